@@ -1,6 +1,11 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <deque>
+#include <cstring>
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#endif
 #include "ExchangeToolkit.h"
 
 namespace ts3d {
@@ -79,6 +84,21 @@ namespace {
 		return result;
 	}
 
+	// Reserves space for one matrix per element of range when the
+	// range knows its size, as InstancePathArray does
+	template<typename Array, typename Range>
+	static inline auto reserveFor( Array &matrices, Range const &range, int ) -> decltype( range.size(), void() ) {
+		matrices.reserve( range.size() );
+	}
+
+	template<typename Array, typename Range>
+	static inline void reserveFor( Array &, Range const &, long ) {
+	}
+
+	template<typename Array, typename Range>
+	static inline void reserveFor( Array &matrices, Range const &range ) {
+		reserveFor( matrices, range, 0 );
+	}
 }
 
 
@@ -93,10 +113,7 @@ namespace ts3d {
 			return ts3d::MatrixType::Identity();
 		}
 
-		auto t = kA3DTypeUnknown;
-		A3DEntityGetType( xform, &t );
-
-		switch(t) {
+		switch(ts3d::getEntityType( xform )) {
 		case kA3DTypeMiscCartesianTransformation:
 			return getMatrixFromCartesian( xform );
 			break;
@@ -110,19 +127,269 @@ namespace ts3d {
 		return ts3d::MatrixType::Identity();
 	}
 
-	/*! \brief Gets the matrix of the leaf entity.
+	/*! \brief Classification of a transformation, from least to most general.
 	*  \ingroup eigen_bridge
 	*/
-	static inline MatrixType getMatrix( ts3d::Instance const &i ) {
-		auto const leaf_type = i.leafType();
-        if( kA3DTypeAsmProductOccurrence == leaf_type ) {
-            return ts3d::getMatrix( getLocation( i.leaf() ) );
-        } else if( isRepresentationItem( leaf_type ) ) {
-            A3DRiRepresentationItemWrapper d( i.leaf() );
+	enum class TransformClass {
+		/*! The transformation has no effect. */
+		Identity,
+		/*! The transformation only translates. */
+		Translation,
+		/*! The transformation rotates and translates, preserving lengths and handedness. */
+		Rigid,
+		/*! The transformation changes lengths, but preserves handedness. */
+		Scaled,
+		/*! The transformation reverses handedness, so the winding of transformed triangles must be reversed. */
+		Mirrored,
+		/*! The transformation is not affine. It cannot be represented by an AffineTransform. */
+		Projective
+	};
+
+	/*! \brief Computes <tt>m * xform</tt>, where \c xform_class is the classification
+	* of \c xform, skipping the work that identity and translation only transformations
+	* do not need.
+	*  \ingroup eigen_bridge
+	*/
+	static inline MatrixType premultiply( MatrixType const &m, MatrixType const &xform, TransformClass const xform_class ) {
+		switch( xform_class ) {
+		case TransformClass::Identity:
+			return m;
+		case TransformClass::Translation: {
+			MatrixType result = m;
+			result.col( 3 ) = m * xform.col( 3 );
+			return result;
+		}
+		default:
+			return m * xform;
+		}
+	}
+
+	/*! \brief A decoded transformation, stored as the upper 3x4 block of its matrix.
+	*
+	* The classification allows work to be skipped for the most common transformations
+	* found in assemblies. Applying an identity transformation is free, and applying a
+	* translation only touches the last column.
+	* \sa TransformCache
+	*  \ingroup eigen_bridge
+	*/
+	struct AffineTransform {
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		/*! \brief Alias for the 3x4 block type.
+		*/
+		using BlockType = Eigen::Matrix<double, 3, 4>;
+
+		/*! \brief Constructs an identity transformation.
+		*/
+		AffineTransform( void )
+		: _block( BlockType::Identity() ), _class( TransformClass::Identity ) {
+		}
+
+		/*! \brief Constructs an affine transformation from \c matrix and classifies it.
+		* The last row of \c matrix is expected to be (0, 0, 0, 1). If it is not,
+		* the transformation is classified as TransformClass::Projective.
+		*/
+		explicit AffineTransform( MatrixType const &matrix )
+		: _block( matrix.topRows<3>() ), _class( classify( matrix ) ) {
+		}
+
+		/*! \brief Gets the 4x4 matrix of the transformation.
+		*/
+		MatrixType matrix( void ) const {
+			MatrixType result;
+			result.topRows<3>() = _block;
+			result.row( 3 ) << 0., 0., 0., 1.;
+			return result;
+		}
+
+		/*! \brief Computes <tt>m * matrix()</tt>, skipping the work that identity
+		* and translation only transformations do not need.
+		*/
+		MatrixType premultiply( MatrixType const &m ) const {
+			return TransformClass::Identity == _class ? m : ts3d::premultiply( m, matrix(), _class );
+		}
+
+		/*! \brief Transforms a position or vector. The w component of \c v is preserved.
+		*/
+		VectorType transform( VectorType const &v ) const {
+			switch( _class ) {
+			case TransformClass::Identity:
+				return v;
+			case TransformClass::Translation:
+				return VectorType( v( 0 ) + _block( 0, 3 ) * v( 3 ), v( 1 ) + _block( 1, 3 ) * v( 3 ), v( 2 ) + _block( 2, 3 ) * v( 3 ), v( 3 ) );
+			default: {
+				VectorType result;
+				result.head<3>() = _block * v;
+				result( 3 ) = v( 3 );
+				return result;
+			}
+			}
+		}
+
+		/*! \brief Classifies \c matrix. Identity and translation are only reported when
+		* the corresponding coefficients are exact, so that skipping work never changes results.
+		*/
+		static TransformClass classify( MatrixType const &matrix ) {
+			if( matrix.row( 3 ) != Eigen::RowVector4d( 0., 0., 0., 1. ) ) {
+				return TransformClass::Projective;
+			}
+			Eigen::Matrix3d const linear = matrix.topLeftCorner<3, 3>();
+			if( linear == Eigen::Matrix3d::Identity() ) {
+				return matrix.topRightCorner<3, 1>().isZero( 0. ) ? TransformClass::Identity : TransformClass::Translation;
+			}
+			if( linear.determinant() < 0. ) {
+				return TransformClass::Mirrored;
+			}
+			auto const tolerance = 1e-12;
+			return (linear.transpose() * linear).isIdentity( tolerance ) ? TransformClass::Rigid : TransformClass::Scaled;
+		}
+
+		/*! \brief The upper 3x4 block of the matrix.
+		*/
+		BlockType _block;
+
+		/*! \brief The classification of the transformation.
+		*/
+		TransformClass _class;
+	};
+
+	/*! \brief Decodes each A3DMiscTransformation once.
+	*
+	* In assemblies the same transformation is commonly referenced by many instance
+	* paths. The cache reads each transformation from Exchange the first time it is
+	* requested and stores its decoded, classified form. The cache may be shared
+	* between threads. Transformations that are not affine are decoded each time
+	* they are requested.
+	* \code
+	* ts3d::TransformCache cache;
+	* auto const location = cache.get( ts3d::getLocation( po ) );
+	* if( ts3d::TransformClass::Identity != location._class ) {
+	*     ...
+	* }
+	* \endcode
+	*  \ingroup eigen_bridge
+	*/
+	class TransformCache {
+	public:
+		/*! \brief Gets the decoded form of \c xform. A null transformation is the identity.
+		*/
+		AffineTransform get( A3DMiscTransformation *xform ) {
+			return decode( xform, nullptr );
+		}
+
+		/*! \brief Gets the decoded form of \c xform, and also its matrix in \c matrix.
+		* The matrix is identical to that returned by getMatrix( A3DMiscTransformation * ),
+		* including for transformations that are not affine.
+		*/
+		AffineTransform get( A3DMiscTransformation *xform, MatrixType &matrix ) {
+			return decode( xform, &matrix );
+		}
+
+		/*! \brief Gets the matrix of \c xform. The result is identical to getMatrix( A3DMiscTransformation * ).
+		*/
+		MatrixType getMatrix( A3DMiscTransformation *xform ) {
+			MatrixType result;
+			decode( xform, &result );
+			return result;
+		}
+
+		/*! \brief The number of transformations decoded.
+		*/
+		size_t size( void ) const {
+			std::lock_guard<std::mutex> const lock( _mutex );
+			return _transforms.size();
+		}
+
+		/*! \brief Removes all decoded transformations.
+		*/
+		void clear( void ) {
+			std::lock_guard<std::mutex> const lock( _mutex );
+			_indices.clear();
+			_transforms.clear();
+			_projective_indices.clear();
+			_projective_matrices.clear();
+		}
+
+	private:
+		AffineTransform decode( A3DMiscTransformation *xform, MatrixType *matrix ) {
+			if( nullptr == xform ) {
+				if( matrix ) {
+					*matrix = MatrixType::Identity();
+				}
+				return AffineTransform();
+			}
+			{
+				std::lock_guard<std::mutex> const lock( _mutex );
+				auto const it = _indices.find( xform );
+				if( std::end( _indices ) != it ) {
+					return stored( it->first, it->second, matrix );
+				}
+			}
+
+			// Decode without holding the lock, since doing so requires the Exchange
+			// API. If another thread decodes the same transformation concurrently,
+			// the first result stored is kept.
+			auto const decoded = ts3d::getMatrix( xform );
+			AffineTransform const transform( decoded );
+			std::lock_guard<std::mutex> const lock( _mutex );
+			auto const result = _indices.emplace( xform, _transforms.size() );
+			if( result.second ) {
+				_transforms.push_back( transform );
+				if( TransformClass::Projective == transform._class ) {
+					_projective_indices.emplace( xform, _projective_matrices.size() );
+					_projective_matrices.push_back( decoded );
+				}
+			}
+			return stored( xform, result.first->second, matrix );
+		}
+
+		// Must be called with the lock held
+		AffineTransform stored( A3DMiscTransformation *xform, size_t const idx, MatrixType *matrix ) const {
+			auto const &transform = _transforms[idx];
+			if( matrix ) {
+				*matrix = TransformClass::Projective == transform._class ? _projective_matrices[_projective_indices.at( xform )] : transform.matrix();
+			}
+			return transform;
+		}
+
+		mutable std::mutex _mutex;
+		std::unordered_map<A3DMiscTransformation*, size_t> _indices;
+		std::deque<AffineTransform, Eigen::aligned_allocator<AffineTransform>> _transforms;
+		std::unordered_map<A3DMiscTransformation*, size_t> _projective_indices;
+		std::deque<MatrixType, Eigen::aligned_allocator<MatrixType>> _projective_matrices;
+	};
+
+	/*! \brief Gets the transformation of an entity. This is the location of a product
+	* occurrence or the transformation of the coordinate system of a representation
+	* item. Any other entity has no transformation.
+	*  \ingroup eigen_bridge
+	*/
+	static inline A3DMiscTransformation *getEntityTransformation( A3DEntity *ntt ) {
+		auto const ntt_type = getEntityType( ntt );
+        if( kA3DTypeAsmProductOccurrence == ntt_type ) {
+            return getLocation( ntt );
+        } else if( isRepresentationItem( ntt_type ) ) {
+            A3DRiRepresentationItemWrapper d( ntt );
             A3DRiCoordinateSystemWrapper csw( d->m_pCoordinateSystem );
-            return  ts3d::getMatrix( csw->m_pTransformation );
+            return csw->m_pTransformation;
         }
-		return MatrixType::Identity();
+		return nullptr;
+	}
+
+	/*! \brief Gets the matrix of an entity. This is the location of a product
+	* occurrence or the transformation of the coordinate system of a representation
+	* item. The matrix of any other entity is the identity.
+	*  \ingroup eigen_bridge
+	*/
+	static inline MatrixType getEntityMatrix( A3DEntity *ntt ) {
+		return ts3d::getMatrix( getEntityTransformation( ntt ) );
+	}
+
+	/*! \brief Gets the matrix of the leaf entity.
+	*  \ingroup eigen_bridge
+	*/
+	static inline MatrixType getMatrix( ts3d::Instance const &i ) {
+		return getEntityMatrix( i.leaf() );
 	}
 
 	/*! \brief Gets the net matrix for a given instance.
@@ -135,8 +402,329 @@ namespace ts3d {
 	*/
 	static inline MatrixType getNetMatrix( ts3d::Instance const &i ) {
 		if(i.path().size() > 1) {
-			return getNetMatrix( i.owner() ) * getMatrix( i );
+			// Accumulate from the root without copying the owner paths
+			MatrixType result = getEntityMatrix( i.path().front() );
+			for(auto idx = 1u; idx < i.path().size(); ++idx) {
+				result = result * getEntityMatrix( i.path()[idx] );
+			}
+			return result;
 		}
 		return getMatrix( i );
 	}
+
+	/*! \brief Alias for an array of matrices, using the allocator Eigen requires for fixed size types.
+	*  \ingroup eigen_bridge
+	*/
+	using MatrixArray = std::vector<MatrixType, Eigen::aligned_allocator<MatrixType>>;
+
+	/*! \brief Computes net matrices for many instance paths, computing the
+	* product for each distinct path prefix exactly once.
+	*
+	* Only product occurrences and representation items carry a transformation,
+	* and instance paths obtained from a traversal typically share a small number
+	* of them. For example, the faces of a part share the path to the part, and
+	* all parts share the paths to the assemblies above them. The cache interns
+	* the sequence of product occurrences and representation items of each path
+	* and stores a net matrix for it, so the net matrix of a path is obtained with
+	* a single multiplication once its parent has been seen. A sequence ending in
+	* an entity whose transformation is the identity shares the matrix of its
+	* parent. The matrix of each entity is read from Exchange only once.
+	*
+	* Entities below the first entity of a path that is not a model file, product
+	* occurrence, part definition or representation item, such as topology or markup,
+	* are not examined, since no entity carrying a transformation can be found below
+	* them. A path that shares this leading portion with the previous path, such as
+	* the next face of the same part, is resolved without further lookups.
+	*
+	* The results are identical to those of getNetMatrix( ts3d::Instance const & ).
+	* A cache is not thread safe. It remains valid only while the entities it has
+	* seen are alive.
+	* \code
+	* ts3d::NetMatrixCache cache;
+	* for( auto const &face_path : ts3d::leafInstances( model_file, kA3DTypeTopoFace ) ) {
+	*     auto const net_matrix = cache.getNetMatrix( face_path );
+	*     ...
+	* }
+	* \endcode
+	* \sa getNetMatrices
+	*  \ingroup eigen_bridge
+	*/
+	class NetMatrixCache {
+	public:
+		/*! \brief Constructs an empty cache.
+		*/
+		NetMatrixCache( void ) {
+			_net_matrices.push_back( MatrixType::Identity() );
+		}
+
+		/*! \brief Gets the net matrix of \c instance_path.
+		*/
+		MatrixType getNetMatrix( InstancePath const &instance_path ) {
+			auto const length = _last_path.size();
+			if( !_last_path_reusable || instance_path.size() < length || !std::equal( _last_path.begin(), _last_path.end(), instance_path.begin() ) ) {
+				resolve( instance_path );
+			}
+			return _net_matrices[_last_net_idx];
+		}
+
+		/*! \brief Gets the matrix of \c ntt, reading it from Exchange only the first time.
+		*/
+		MatrixType const &getEntityMatrix( A3DEntity *ntt ) {
+			return _matrices[getEntityIndex( ntt )];
+		}
+
+		/*! \brief The number of distinct net matrices stored, including the identity.
+		*/
+		size_t size( void ) const {
+			return _net_matrices.size();
+		}
+
+		/*! \brief Removes all cached matrices.
+		*/
+		void clear( void ) {
+			_interner.clear();
+			_net_indices.clear();
+			_net_matrices.clear();
+			_net_matrices.push_back( MatrixType::Identity() );
+			_matrix_indices.clear();
+			_matrices.clear();
+			_classes.clear();
+			_transforms.clear();
+			_last_path.clear();
+			_last_path_reusable = false;
+			_last_net_idx = 0u;
+		}
+
+	private:
+		// Determines the net matrix of instance_path and records the
+		// leading portion of the path it depends on
+		void resolve( InstancePath const &instance_path ) {
+			_transform_path.clear();
+			_last_path.clear();
+			_last_path_reusable = false;
+			for(auto const ntt : instance_path) {
+				_last_path.push_back( ntt );
+				auto const ntt_type = getEntityType( ntt );
+				if( kA3DTypeAsmProductOccurrence == ntt_type || isRepresentationItem( ntt_type ) ) {
+					_transform_path.push_back( ntt );
+				} else if( kA3DTypeAsmModelFile != ntt_type && kA3DTypeAsmPartDefinition != ntt_type ) {
+					_last_path_reusable = true;
+					break;
+				}
+			}
+			_last_net_idx = _transform_path.empty() ? 0u : getNetIndex( _interner.intern( _transform_path ) );
+		}
+
+		size_t getNetIndex( InstancePathHandle const handle ) {
+			for(auto idx = _net_indices.size(); idx < _interner.size(); ++idx) {
+				// Handles are dense and parents are always interned before
+				// their children, so each parent matrix is already available
+				auto const prefix = static_cast<InstancePathHandle>( idx );
+				auto const parent = _interner.parent( prefix );
+				auto const parent_net_idx = PathInterner::invalidHandle() == parent ? 0u : _net_indices[parent];
+				auto const entity_idx = getEntityIndex( _interner.leaf( prefix ) );
+				if( TransformClass::Identity == _classes[entity_idx] ) {
+					_net_indices.push_back( parent_net_idx );
+				} else {
+					_net_indices.push_back( _net_matrices.size() );
+					_net_matrices.push_back( premultiply( _net_matrices[parent_net_idx], _matrices[entity_idx], _classes[entity_idx] ) );
+				}
+			}
+			return _net_indices[handle];
+		}
+
+		size_t getEntityIndex( A3DEntity *ntt ) {
+			auto const result = _matrix_indices.emplace( ntt, _matrices.size() );
+			if( result.second ) {
+				// Product occurrences that share a prototype share its location,
+				// so each transformation is decoded once rather than once per entity
+				auto const xform = getEntityTransformation( ntt );
+				MatrixType matrix;
+				_classes.push_back( _transforms.get( xform, matrix )._class );
+				_matrices.push_back( matrix );
+			}
+			return result.first->second;
+		}
+
+		PathInterner _interner;
+		std::vector<size_t> _net_indices;
+		MatrixArray _net_matrices;
+		std::unordered_map<A3DEntity*, size_t> _matrix_indices;
+		MatrixArray _matrices;
+		std::vector<TransformClass> _classes;
+		TransformCache _transforms;
+		InstancePath _transform_path;
+		InstancePath _last_path;
+		bool _last_path_reusable = false;
+		size_t _last_net_idx = 0u;
+	};
+
+	/*! \brief Gets the net matrix of each instance path in \c instance_paths,
+	* using \c cache to share work between paths and between calls.
+	* \param instance_paths Any range of instance paths, such as an InstancePathArray
+	* or the range returned by leafInstances().
+	* \param cache The cache used to compute the matrices.
+	* \return The net matrices, in the same order as \c instance_paths.
+	*  \ingroup eigen_bridge
+	*/
+	template<typename InstancePathRange>
+	static inline MatrixArray getNetMatrices( InstancePathRange const &instance_paths, NetMatrixCache &cache ) {
+		MatrixArray result;
+		reserveFor( result, instance_paths );
+		for(auto const &instance_path : instance_paths) {
+			result.push_back( cache.getNetMatrix( instance_path ) );
+		}
+		return result;
+	}
+
+	/*! \brief Gets the net matrix of each instance path in \c instance_paths.
+	* The product for each distinct path prefix is computed once. \sa NetMatrixCache
+	* \return The net matrices, in the same order as \c instance_paths.
+	*  \ingroup eigen_bridge
+	*/
+	template<typename InstancePathRange>
+	static inline MatrixArray getNetMatrices( InstancePathRange const &instance_paths ) {
+		NetMatrixCache cache;
+		return getNetMatrices( instance_paths, cache );
+	}
+}
+
+namespace {
+	// Computes dst = block * (src, w) for n vectors of 3 packed doubles, where w
+	// is 1 for points and 0 for directions. dst may be the same array as src.
+	// Directions are renormalized if Normalize is set. Zero length directions
+	// are left as zero.
+	template<bool Normalize>
+	static inline void transformPacked( Eigen::Matrix<double, 3, 4> const &block, double const *src, double *dst, size_t const n ) {
+		// Local coefficients, since the stores to dst could otherwise alias block
+		double const m00 = block( 0, 0 ), m01 = block( 0, 1 ), m02 = block( 0, 2 ), m03 = block( 0, 3 );
+		double const m10 = block( 1, 0 ), m11 = block( 1, 1 ), m12 = block( 1, 2 ), m13 = block( 1, 3 );
+		double const m20 = block( 2, 0 ), m21 = block( 2, 1 ), m22 = block( 2, 2 ), m23 = block( 2, 3 );
+		auto idx = size_t( 0u );
+#if defined( __AVX2__ )
+		// Four vectors (12 doubles) are transposed to x, y and z registers,
+		// transformed, and transposed back.
+		auto const v00 = _mm256_set1_pd( m00 ), v01 = _mm256_set1_pd( m01 ), v02 = _mm256_set1_pd( m02 ), v03 = _mm256_set1_pd( m03 );
+		auto const v10 = _mm256_set1_pd( m10 ), v11 = _mm256_set1_pd( m11 ), v12 = _mm256_set1_pd( m12 ), v13 = _mm256_set1_pd( m13 );
+		auto const v20 = _mm256_set1_pd( m20 ), v21 = _mm256_set1_pd( m21 ), v22 = _mm256_set1_pd( m22 ), v23 = _mm256_set1_pd( m23 );
+		auto const zero = _mm256_setzero_pd();
+		auto const one = _mm256_set1_pd( 1. );
+		for( ; idx + 4u <= n; idx += 4u ) {
+			auto const in = src + 3u * idx;
+			auto const a = _mm256_loadu_pd( in );
+			auto const b = _mm256_loadu_pd( in + 4 );
+			auto const c = _mm256_loadu_pd( in + 8 );
+			auto const xy = _mm256_blend_pd( a, b, 0xc );
+			auto const zx = _mm256_permute2f128_pd( a, c, 0x21 );
+			auto const yz = _mm256_blend_pd( b, c, 0xc );
+			auto const x = _mm256_shuffle_pd( xy, zx, 0xa );
+			auto const y = _mm256_shuffle_pd( xy, yz, 0x5 );
+			auto const z = _mm256_shuffle_pd( zx, yz, 0xa );
+
+			auto tx = _mm256_add_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( v00, x ), _mm256_mul_pd( v01, y ) ), _mm256_mul_pd( v02, z ) ), v03 );
+			auto ty = _mm256_add_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( v10, x ), _mm256_mul_pd( v11, y ) ), _mm256_mul_pd( v12, z ) ), v13 );
+			auto tz = _mm256_add_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( v20, x ), _mm256_mul_pd( v21, y ) ), _mm256_mul_pd( v22, z ) ), v23 );
+			if( Normalize ) {
+				auto const length = _mm256_sqrt_pd( _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( tx, tx ), _mm256_mul_pd( ty, ty ) ), _mm256_mul_pd( tz, tz ) ) );
+				auto const scale = _mm256_and_pd( _mm256_cmp_pd( length, zero, _CMP_GT_OQ ), _mm256_div_pd( one, length ) );
+				tx = _mm256_mul_pd( tx, scale );
+				ty = _mm256_mul_pd( ty, scale );
+				tz = _mm256_mul_pd( tz, scale );
+			}
+
+			auto const out_xy = _mm256_shuffle_pd( tx, ty, 0x0 );
+			auto const out_zx = _mm256_shuffle_pd( tz, tx, 0xa );
+			auto const out_yz = _mm256_shuffle_pd( ty, tz, 0xf );
+			auto const out = dst + 3u * idx;
+			_mm256_storeu_pd( out, _mm256_permute2f128_pd( out_xy, out_zx, 0x20 ) );
+			_mm256_storeu_pd( out + 4, _mm256_blend_pd( out_yz, out_xy, 0xc ) );
+			_mm256_storeu_pd( out + 8, _mm256_permute2f128_pd( out_zx, out_yz, 0x31 ) );
+		}
+#endif
+		auto out = dst + 3u * idx;
+		for( auto in = src + 3u * idx; idx < n; ++idx, in += 3, out += 3 ) {
+			auto const x = in[0];
+			auto const y = in[1];
+			auto const z = in[2];
+			auto tx = m00 * x + m01 * y + m02 * z + m03;
+			auto ty = m10 * x + m11 * y + m12 * z + m13;
+			auto tz = m20 * x + m21 * y + m22 * z + m23;
+			if( Normalize ) {
+				auto const length = std::sqrt( tx * tx + ty * ty + tz * tz );
+				auto const scale = length > 0. ? 1. / length : 0.;
+				tx *= scale;
+				ty *= scale;
+				tz *= scale;
+			}
+			out[0] = tx;
+			out[1] = ty;
+			out[2] = tz;
+		}
+	}
+}
+
+namespace ts3d {
+	/*! \brief Transforms an array of packed (x, y, z) points, such as the
+	* \c m_pdCoords array of a tessellation, by \c matrix.
+	*
+	* This is much faster than transforming each point as a VectorType. When
+	* compiled with AVX2 enabled, four points are transformed at once.
+	* \param matrix The transformation, typically from getNetMatrix().
+	* \param src The points to transform.
+	* \param dst Receives the transformed points. May be the same array as \c src.
+	* \param n_points The number of points, that is, a third of the array length.
+	*  \ingroup eigen_bridge
+	*/
+	static inline void transformPoints( MatrixType const &matrix, double const *src, double *dst, size_t const n_points ) {
+		switch( AffineTransform::classify( matrix ) ) {
+		case TransformClass::Identity:
+			if( src != dst ) {
+				std::memcpy( dst, src, 3u * n_points * sizeof( double ) );
+			}
+			break;
+		case TransformClass::Projective:
+			for( auto idx = 0u; idx < n_points; ++idx ) {
+				PositionType const p = matrix * PositionType( src[3u * idx], src[3u * idx + 1u], src[3u * idx + 2u], 1. );
+				dst[3u * idx] = p( 0 ) / p( 3 );
+				dst[3u * idx + 1u] = p( 1 ) / p( 3 );
+				dst[3u * idx + 2u] = p( 2 ) / p( 3 );
+			}
+			break;
+		default:
+			transformPacked<false>( matrix.topRows<3>(), src, dst, n_points );
+			break;
+		}
+	}
+
+	/*! \brief Transforms an array of packed (x, y, z) normal vectors, such as the
+	* \c m_pdNormals array of a tessellation, by \c matrix.
+	*
+	* Normals are transformed by the inverse transpose of the linear part of
+	* \c matrix and renormalized, so they remain perpendicular to the transformed
+	* surface under scaling. Rotations only need neither.
+	* \param matrix The transformation, typically from getNetMatrix().
+	* \param src The normals to transform.
+	* \param dst Receives the transformed normals. May be the same array as \c src.
+	* \param n_normals The number of normals, that is, a third of the array length.
+	*  \ingroup eigen_bridge
+	*/
+	static inline void transformNormals( MatrixType const &matrix, double const *src, double *dst, size_t const n_normals ) {
+		auto const xform_class = AffineTransform::classify( matrix );
+		if( TransformClass::Identity == xform_class || TransformClass::Translation == xform_class ) {
+			if( src != dst ) {
+				std::memcpy( dst, src, 3u * n_normals * sizeof( double ) );
+			}
+			return;
+		}
+
+		Eigen::Matrix<double, 3, 4> block = Eigen::Matrix<double, 3, 4>::Zero();
+		auto const rigid = TransformClass::Rigid == xform_class;
+		Eigen::Matrix3d const linear = matrix.topLeftCorner<3, 3>();
+		block.leftCols<3>() = rigid ? linear : Eigen::Matrix3d( linear.inverse().transpose() );
+		if( rigid ) {
+			transformPacked<false>( block, src, dst, n_normals );
+		} else {
+			transformPacked<true>( block, src, dst, n_normals );
+		}
+	}
 }
@@ -49,6 +49,15 @@ not address any mathematical operations on these objects.
 The Exchange Toolkit provides a bridge to easily convert from Exchange objects to
 the more standard [Eigen](http://eigen.tuxfamily.org/index.php?title=Main_Page) toolkit.
 
+When net matrices are needed for many instance paths, such as every face of a large
+assembly, ts3d::getNetMatrices() and ts3d::NetMatrixCache compute the product for each
+shared path prefix only once. ts3d::TransformCache decodes each transformation once and
+classifies it, so that work can be skipped for identity and translation only transformations.
+
+To place tessellation in world space, ts3d::transformPoints() and ts3d::transformNormals()
+transform entire coordinate and normal arrays with a single call, using AVX2 when it is
+enabled at compile time.
+
 \section section_examples Examples
 Perhaps you learn best by [example](@ref examples)?
 
@@ -129,6 +138,27 @@ the Exchange data model. They are:
 
 	
 
+	If the number of results is large, or if you may not need all of them, use the
+	streaming variant ts3d::leafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type ) instead.
+	It yields the same paths in the same order, one at a time, without materializing the array.
+	\code
+		for( auto const &part_path : ts3d::leafInstances( loader.m_psModelFile, kA3DTypeAsmPartDefinition ) ) {
+			if( isTheOneImLookingFor( part_path ) ) {
+				break;
+			}
+		}
+	\endcode
+
+	When several leaf types are needed from the same owner, pass them all at once to
+	ts3d::getLeafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types ). The hierarchy
+	is walked a single time and the instance paths are returned per leaf type, each array identical
+	to the one obtained with a separate call.
+	\code
+		auto const paths_by_type = ts3d::getLeafInstances( loader.m_psModelFile, { kA3DTypeRiRepresentationItem, kA3DTypeMkpMarkup } );
+		auto const &ri_paths = paths_by_type.at( kA3DTypeRiRepresentationItem );
+		auto const &markup_paths = paths_by_type.at( kA3DTypeMkpMarkup );
+	\endcode
+
 -# ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type );
 
 	This function is used to obtain a set of unique child objects of type \c leaf_type. The result
@@ -148,7 +178,13 @@ the Exchange data model. They are:
 	This overloaded variation can be used when you need a collection of unique child objects of a particular
 	type _and_ you want the instance paths for each occurrence. The final parameter \c instance_path_map
 	is used with each entity from the returned set as key values. The lookup returns an array of instance
-	paths indicating the unique occurrences of the child object. The following code snippet from the 
+	paths indicating the unique occurrences of the child object.
+
+	If only the number of occurrences of each child is needed, use
+	ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstanceCountMap &instance_counts )
+	instead. It provides the counts without constructing any instance paths, so its cost is proportional to the number
+	of unique entities rather than the number of occurrences. The ts3d::countLeafInstances() family of functions
+	similarly provides total occurrence counts. The following code snippet from the 
 	[bom](@ref example_bom)	example shows how to easily print a bill of materials.
 	\snippet bom/main.cpp  Constructing a BOM
 	Using <tt>samples/data/catiaV5/CV5_Micro_Engine/_micro engine.CATProduct</tt> as input, this code writes the
@@ -282,6 +318,13 @@ partProcessingAlgorithm( ts3d::A3DAsmProductOccurrentWrapper( getSomePO() )->m_p
 
 \sa wrappers
 
+To find out where time is spent reading data, define \c TS3D_ENABLE_INSTRUMENTATION for all
+translation units that include the toolkit. Each \c Get call made by the wrappers is then counted
+and timed per data type, and the results can be read with ts3d::Instrumentation::snapshot().
+When the symbol is not defined, the wrappers call the Exchange API directly and nothing is recorded.
+
+\sa ts3d::Instrumentation
+
 \section instance_section Concept: Instance
 The class ts3d::Instance provides additional functionality for computing "net attributes" that
 are based on a specific ts3d::InstancePath. 
@@ -379,7 +422,14 @@ The Exchange toolkit provides an abstraction that simplifies access to the trian
 make up a topological face. The class that provides this functionality is ts3d::Tess3DInstance.
 This is a concrete implementation of ts3d::TessBaseInstance returned from the call to
 ts3d::RepresentationItemInstance::getTessellation(). From this object you can obtain a 
-ts3d::TessFaceDataHelper object for each face.
+ts3d::TessFaceDataHelper object for each face, or the triangles of all faces at once with
+ts3d::Tess3DInstance::getIndexMesh().
+
+When the tessellation is destined for a GPU, ts3d::Tess3DInstance::getInterleavedMesh() merges
+the separate point and normal indexes into a single index buffer. The result can be reduced
+with ts3d::toFloat32(), which rebases the positions to keep single precision accuracy, or with
+ts3d::quantize(), which stores 16 bit positions, octahedral normals and half float texture
+coordinates along with the parameters needed to restore them.
 
 Refer to this snippet of code extracted from [examples/obj/main.cpp](@ref example_obj) as an 
 example of how this functionality can be used. This code writes the tessellation data to an
@@ -399,8 +449,20 @@ edge.
 
 
 \subsection Wires
-\todo Implement and test wire tessellation objects
-\note This implementation is incomplete!
+Representation items with wire tessellation, such as those read when \c m_bReadWireframes is set,
+provide a ts3d::Tess3DWireInstance from ts3d::RepresentationItemInstance::getTessellation().
+The point offsets of all wires are available in a single array, ts3d::Tess3DWireInstance::vertices(),
+which ts3d::Tess3DWireInstance::offsets() divides into wires. Wire colors are packed into one
+32 bit value each by ts3d::Tess3DWireInstance::colors().
+
+
+\subsection Markup
+The tessellation of a markup, the \c m_pTessellation member of \c A3DMkpMarkupData, is a stream
+of codes that mixes primitives with changes to the drawing state. ts3d::TessMarkupInstance decodes
+the stream once, when it is constructed, into flat buffers of polylines, triangles, points and
+text runs. Consecutive primitives that share a color, line style, font, transformation and mode
+are grouped into a ts3d::TessMarkupInstance::Batch, so each batch can be drawn with a single
+state change.
 
 \page examples Examples
 \tableofcontents
@@ -456,12 +518,26 @@ has a wrapper entry below.
 
 #include <vector>
 #include <set>
+#include <map>
 #include <unordered_map>
 #include <functional>
 #include <memory>
 #include <algorithm>
 #include <iterator>
 #include <iostream>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <tuple>
+#include <exception>
+#include <stdexcept>
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -474,7 +550,11 @@ namespace ts3d {
      \brief This class is used to log calls to the Exchange API.
      
      Information about each call is recorded when you use the macro
-     \c CheckResult
+     \c CheckResult. The most recent call is recorded separately for each
+     thread, so the getters report the last call made by the calling thread
+     and the failure callback is invoked on the thread that made the call.
+     The failure callback itself is shared by all threads and should be set
+     before any concurrent use.
      */
     class CheckResult {
     public:
@@ -499,25 +579,25 @@ namespace ts3d {
         /*! \brief Gets the filename where the last call was invoked from.
          */
         std::string const &file( void ) const {
-            return _file;
+            return lastCall()._file;
         }
         
         /*! \brief Gets the line number where the last call was invoked from.
          */
         int const &line( void ) const {
-            return _line;
+            return lastCall()._line;
         }
         
         /*! \brief Gets the stringified representation of the last function call.
          */
         std::string const &fn( void ) const {
-            return _fn;
+            return lastCall()._fn;
         }
         
         /*! \brief Gets the return code resulting from the last function call.
          */
         A3DStatus const &result( void ) const {
-            return _result;
+            return lastCall()._result;
         }
         
         
@@ -525,24 +605,35 @@ namespace ts3d {
          \internal
          */
         bool _record( std::string const file, int const line_no, std::string const fn, A3DStatus const result ) {
-            _file = file;
-            _line = line_no;
-            _fn = fn;
-            _result = result;
-            if( _result != A3D_SUCCESS && _failureCallback ) {
+            auto &last_call = lastCall();
+            last_call._file = file;
+            last_call._line = line_no;
+            last_call._fn = fn;
+            last_call._result = result;
+            if( result != A3D_SUCCESS && _failureCallback ) {
                 return _failureCallback(*this);
             }
-            return A3D_SUCCESS == _result;
+            return A3D_SUCCESS == result;
         }
         
     private:
         CheckResult( void ) {}
         CheckResult( CheckResult const &other ) = delete;
         
-        std::string _file;
-        int _line = 0;
-        std::string _fn;
-        A3DStatus _result = A3D_SUCCESS;
+        // The most recent call made by a thread. Calls are recorded per
+        // thread, since the traversal callbacks may run concurrently
+        struct LastCall {
+            std::string _file;
+            int _line = 0;
+            std::string _fn;
+            A3DStatus _result = A3D_SUCCESS;
+        };
+        
+        static LastCall &lastCall( void ) {
+            static thread_local LastCall _last_call;
+            return _last_call;
+        }
+        
         std::function<bool(CheckResult const&)> _failureCallback = [](ts3d::CheckResult const &r ) {
             std::string const error_string = A3DMiscGetErrorMsg( r.result() );
             std::cerr << "API FAILURE: " << r.fn() << " [" << r.file() << ":" << r.line() << "] == " << error_string << "(" << r.result() << ")" << std::endl;
@@ -552,6 +643,332 @@ namespace ts3d {
     };
 }
 
+namespace ts3d {
+    /*!
+     \class ApiLock
+     \brief Scoped lock used to serialize calls to the Exchange API.
+
+     Serialization is selected at compile time by defining \c TS3D_SERIALIZE_API_CALLS
+     before including ExchangeToolkit.h. The definition must be the same in every
+     translation unit, so it is best supplied on the compiler command line. When it
+     is defined, an ApiLock holds a single global mutex for its lifetime. The data
+     access wrappers (see A3D_HELPERS), ts3d::getEntityType() and every other call
+     the toolkit makes to the Exchange API hold one, so that the parallel traversal
+     functions can be used with an Exchange version that does not permit concurrent
+     calls. When it is not defined, an ApiLock does nothing and no mutex is used.
+
+     Without serialization, the toolkit's own state remains thread safe: the
+     CheckResult record is kept per thread and the instrumentation counters are
+     per thread. What is not protected is the Exchange API itself, so the
+     parallel traversal functions and the callbacks they invoke are only safe
+     with an Exchange version that permits concurrent calls, such as concurrent
+     \c Get calls on distinct entities. Caches such as CascadedAttributesCache
+     and NetMatrixCache are never thread safe and must not be shared between
+     threads in either case.
+     \ingroup access
+     */
+    class ApiLock {
+    public:
+        /*! \brief Indicates if serialization was enabled at compile time.
+         */
+        static bool enabled( void ) {
+#ifdef TS3D_SERIALIZE_API_CALLS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+#ifdef TS3D_SERIALIZE_API_CALLS
+        /*! \brief Acquires the global mutex. The mutex is recursive, so calls
+         *  may be nested.
+         */
+        ApiLock( void ) {
+            mutex().lock();
+        }
+
+        /*! \brief Releases the global mutex.
+         */
+        ~ApiLock( void ) {
+            mutex().unlock();
+        }
+#else
+        ApiLock( void ) {
+        }
+#endif
+
+    private:
+        ApiLock( ApiLock const &other ) = delete;
+        ApiLock &operator=( ApiLock const &other ) = delete;
+
+#ifdef TS3D_SERIALIZE_API_CALLS
+        static std::recursive_mutex &mutex( void ) {
+            static std::recursive_mutex _mutex;
+            return _mutex;
+        }
+#endif
+    };
+}
+
+namespace ts3d {
+    /*! \brief Counters aggregated across all threads by Instrumentation::snapshot().
+     * \ingroup access
+     */
+    struct InstrumentationSnapshot {
+        /*! \brief Counters for the \c Get calls made for a single Exchange data type.
+         */
+        struct GetCounters {
+            /*! \brief The Exchange type name, for example "A3DAsmProductOccurrence". */
+            std::string _type;
+            /*! \brief The number of calls made, including calls made to free the data. */
+            A3DUns64 _calls = 0u;
+            /*! \brief The total time spent in the calls. */
+            A3DUns64 _nanoseconds = 0u;
+        };
+
+        /*! \brief Counters for each type that has been accessed, in the order first accessed. */
+        std::vector<GetCounters> _gets;
+        /*! \brief The number of instance paths produced by traversal. */
+        A3DUns64 _paths = 0u;
+        /*! \brief The greatest number of entities in an instance path encountered during traversal. */
+        A3DUns64 _max_depth = 0u;
+        /*! \brief The number of bytes allocated for instance paths returned to the caller. */
+        A3DUns64 _path_bytes = 0u;
+    };
+
+    /*!
+     \class Instrumentation
+     \brief Counts and times calls made to the Exchange API, and measures traversal.
+
+     Instrumentation is selected at compile time by defining \c TS3D_ENABLE_INSTRUMENTATION
+     before including ExchangeToolkit.h. The definition must be the same in every
+     translation unit, so it is best supplied on the compiler command line. When it
+     is defined, every \c Get call issued by the data access wrappers (see A3D_HELPERS)
+     and by ts3d::getEntityType() is counted and timed, and traversal functions record
+     the number and size of the instance paths they produce. When it is not defined, no
+     instrumentation code is compiled and snapshot() returns empty counters.
+
+     Counters are kept per thread so that recording does not require synchronization.
+     snapshot() aggregates the counters of all threads, including threads that have exited.
+     \code
+     ts3d::Instrumentation::reset();
+     auto const faces = ts3d::getLeafInstances( model_file, kA3DTypeTopoFace );
+     auto const snapshot = ts3d::Instrumentation::snapshot();
+     for( auto const &get : snapshot._gets ) {
+         std::cout << get._type << ": " << get._calls << " calls, " << get._nanoseconds / 1000000 << " ms" << std::endl;
+     }
+     \endcode
+     \ingroup access
+     */
+    class Instrumentation {
+    public:
+        /*! \brief Indicates if instrumentation was enabled at compile time.
+         */
+        static bool enabled( void ) {
+#ifdef TS3D_ENABLE_INSTRUMENTATION
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /*! \brief Aggregates the counters of all threads.
+         */
+        static InstrumentationSnapshot snapshot( void ) {
+            auto &registry = Registry::instance();
+            std::lock_guard<std::mutex> const lock( registry._mutex );
+            Counters total;
+            total.add( registry._retired );
+            for( auto const counters : registry._threads ) {
+                total.add( *counters );
+            }
+            InstrumentationSnapshot result;
+            for( auto slot = 0u; slot < registry._type_names.size(); ++slot ) {
+                InstrumentationSnapshot::GetCounters get;
+                get._type = registry._type_names[slot];
+                get._calls = load( total._get_calls[slot] );
+                get._nanoseconds = load( total._get_nanoseconds[slot] );
+                result._gets.push_back( get );
+            }
+            result._paths = load( total._paths );
+            result._max_depth = load( total._max_depth );
+            result._path_bytes = load( total._path_bytes );
+            return result;
+        }
+
+        /*! \brief Sets all counters to zero. Counts recorded concurrently by other threads may be lost.
+         */
+        static void reset( void ) {
+            auto &registry = Registry::instance();
+            std::lock_guard<std::mutex> const lock( registry._mutex );
+            registry._retired.clear();
+            for( auto const counters : registry._threads ) {
+                counters->clear();
+            }
+        }
+
+        /*! \private
+         * \brief Obtains the counter slot for the Exchange type \c DataType, registering \c type_name on first use.
+         */
+        template<typename DataType>
+        static size_t slot( char const *type_name ) {
+            static size_t const _slot = registerType( type_name );
+            return _slot;
+        }
+
+        /*! \private
+         * \brief Invokes \c get( ntt, d ), recording the call and its duration in \c slot.
+         */
+        template<typename GetFunction, typename EntityPointer, typename DataPointer>
+        static A3DStatus timeGet( size_t const slot, GetFunction const &get, EntityPointer const ntt, DataPointer const d ) {
+            auto const start = std::chrono::steady_clock::now();
+            auto const result = get( ntt, d );
+            auto const nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+            auto &counters = threadCounters();
+            increment( counters._get_calls[slot], 1u );
+            increment( counters._get_nanoseconds[slot], static_cast<A3DUns64>( nanoseconds ) );
+            return result;
+        }
+
+        /*! \private
+         * \brief Records an instance path of \c depth entities produced by traversal.
+         */
+        static void recordPath( size_t const depth ) {
+            auto &counters = threadCounters();
+            increment( counters._paths, 1u );
+            if( depth > load( counters._max_depth ) ) {
+                counters._max_depth.store( depth, std::memory_order_relaxed );
+            }
+        }
+
+        /*! \private
+         * \brief Records \c byte_count bytes allocated for instance paths returned to the caller.
+         */
+        static void recordPathBytes( size_t const byte_count ) {
+            increment( threadCounters()._path_bytes, byte_count );
+        }
+
+    private:
+        // The number of Exchange types that can be counted individually.
+        // Any further types share the last slot.
+        static size_t const MaxTypeCount = 256u;
+
+        using Counter = std::atomic<A3DUns64>;
+
+        // Each counter is only written by its owning thread, so a relaxed
+        // load and store suffices and avoids a locked read-modify-write
+        static A3DUns64 load( Counter const &counter ) {
+            return counter.load( std::memory_order_relaxed );
+        }
+
+        static void increment( Counter &counter, A3DUns64 const value ) {
+            counter.store( load( counter ) + value, std::memory_order_relaxed );
+        }
+
+        struct Counters {
+            Counters( void ) {
+                clear();
+            }
+
+            void clear( void ) {
+                for( auto slot = 0u; slot < MaxTypeCount; ++slot ) {
+                    _get_calls[slot].store( 0u, std::memory_order_relaxed );
+                    _get_nanoseconds[slot].store( 0u, std::memory_order_relaxed );
+                }
+                _paths.store( 0u, std::memory_order_relaxed );
+                _max_depth.store( 0u, std::memory_order_relaxed );
+                _path_bytes.store( 0u, std::memory_order_relaxed );
+            }
+
+            void add( Counters const &other ) {
+                for( auto slot = 0u; slot < MaxTypeCount; ++slot ) {
+                    increment( _get_calls[slot], load( other._get_calls[slot] ) );
+                    increment( _get_nanoseconds[slot], load( other._get_nanoseconds[slot] ) );
+                }
+                increment( _paths, load( other._paths ) );
+                _max_depth.store( std::max( load( _max_depth ), load( other._max_depth ) ), std::memory_order_relaxed );
+                increment( _path_bytes, load( other._path_bytes ) );
+            }
+
+            Counter _get_calls[MaxTypeCount];
+            Counter _get_nanoseconds[MaxTypeCount];
+            Counter _paths;
+            Counter _max_depth;
+            Counter _path_bytes;
+        };
+
+        // Tracks the counters of live threads. The counters of a thread are
+        // folded into _retired when the thread exits.
+        struct Registry {
+            static Registry &instance( void ) {
+                static Registry _instance;
+                return _instance;
+            }
+
+            std::mutex _mutex;
+            std::vector<std::string> _type_names;
+            std::vector<Counters*> _threads;
+            Counters _retired;
+        };
+
+        struct ThreadRegistration {
+            ThreadRegistration( void ) {
+                auto &registry = Registry::instance();
+                std::lock_guard<std::mutex> const lock( registry._mutex );
+                registry._threads.push_back( &_counters );
+            }
+
+            ~ThreadRegistration( void ) {
+                auto &registry = Registry::instance();
+                std::lock_guard<std::mutex> const lock( registry._mutex );
+                registry._retired.add( _counters );
+                registry._threads.erase( std::remove( registry._threads.begin(), registry._threads.end(), &_counters ), registry._threads.end() );
+            }
+
+            Counters _counters;
+        };
+
+        static Counters &threadCounters( void ) {
+            static thread_local ThreadRegistration _registration;
+            return _registration._counters;
+        }
+
+        static size_t registerType( char const *type_name ) {
+            auto &registry = Registry::instance();
+            std::lock_guard<std::mutex> const lock( registry._mutex );
+            if( registry._type_names.size() + 1u < MaxTypeCount ) {
+                registry._type_names.push_back( type_name );
+            } else if( registry._type_names.size() + 1u == MaxTypeCount ) {
+                registry._type_names.push_back( "<other>" );
+            }
+            return registry._type_names.size() - 1u;
+        }
+    };
+}
+
+#ifdef TS3D_ENABLE_INSTRUMENTATION
+/*! \private
+ * \brief Issues <tt>function( ntt, d )</tt>, counting and timing it under \c name if instrumentation is enabled.
+ * \c DataType identifies the counter and must be unique to \c name.
+ */
+#define TS3D_CALL( DataType, name, function, ntt, d ) \
+    ts3d::Instrumentation::timeGet( ts3d::Instrumentation::slot<DataType>( name ), function, ntt, d )
+/*! \private
+ * \brief Expands to \c statement only if instrumentation is enabled.
+ */
+#define TS3D_INSTRUMENT( statement ) statement
+#else
+#define TS3D_CALL( DataType, name, function, ntt, d ) \
+    function( ntt, d )
+#define TS3D_INSTRUMENT( statement )
+#endif
+
+/*! \private
+ * \brief Issues <tt>A3D_VOID_TYPE ## Get( ntt, d )</tt>, counting and timing it if instrumentation is enabled.
+ */
+#define TS3D_GET( A3D_VOID_TYPE, ntt, d ) \
+    TS3D_CALL( A3D_VOID_TYPE ## Data, #A3D_VOID_TYPE, A3D_VOID_TYPE ## Get, ntt, d )
+
 /*!
  \brief If you wrap all of your Exchange API calls in this macro,
  information about the call is recorded in the object \c ts3d::CheckResult::instance().
@@ -583,12 +1000,16 @@ struct A3D_VOID_TYPE ## Wrapper { \
     /*!  This can be a \c nullptr, in which case the \c A3DRootBaseData struct is initialized but not populated. */ \
     A3D_VOID_TYPE ## Wrapper( A3D_VOID_TYPE *ntt = nullptr ) { \
         A3D_INITIALIZE_DATA( A3D_VOID_TYPE ## Data, _d ); \
-        if( ntt ) A3D_VOID_TYPE ## Get( ntt, &_d ); \
+        if( ntt ) { \
+            ts3d::ApiLock const lock; \
+            TS3D_GET( A3D_VOID_TYPE, ntt, &_d ); \
+        } \
     } \
     \
     /*! \brief The destructor is implemented to call <tt>A3D_VOID_TYPE ## Get( nullptr, &_d )</tt> to ensure dynamic resources are freed. */ \
     ~A3D_VOID_TYPE ## Wrapper( void ) { \
-        A3D_VOID_TYPE ## Get( nullptr, &_d ); \
+        ts3d::ApiLock const lock; \
+        TS3D_GET( A3D_VOID_TYPE, nullptr, &_d ); \
     } \
     \
     /*! \brief Const data access to \c A3D_VOID_TYPE ## Data. */ \
@@ -607,8 +1028,9 @@ struct A3D_VOID_TYPE ## Wrapper { \
     /*!  Calling this function will free dynamic resources as needed prior to obtaining new values in the struct.
     If a \c nullptr is provided, the data is not explicitly changed and may reflect old values. */ \
     void reset( A3D_VOID_TYPE *ntt ) { \
-        A3D_VOID_TYPE ## Get( nullptr, &_d ); \
-        if( ntt ) A3D_VOID_TYPE ## Get( ntt, &_d ); \
+        ts3d::ApiLock const lock; \
+        TS3D_GET( A3D_VOID_TYPE, nullptr, &_d ); \
+        if( ntt ) TS3D_GET( A3D_VOID_TYPE, ntt, &_d ); \
     }\
     \
     /*!  \brief Data storage */ \
@@ -892,7 +1314,8 @@ namespace ts3d {
     inline A3DEEntityType getEntityType( A3DEntity *ntt ) {
         auto result = kA3DTypeUnknown;
         if( nullptr != ntt ) {
-            A3DEntityGetType( ntt, &result );
+            ApiLock const lock;
+            TS3D_CALL( A3DEEntityType, "A3DEntityGetType", A3DEntityGetType, ntt, &result );
         }
         return result;
     }
@@ -1041,6 +1464,11 @@ namespace ts3d {
 
     /*! \brief Returns a set of \c A3DEntity pointers that are unique leaf entities
      * of type leaf_type of the provided owner. 
+     *
+     * Entities shared by several instances, such as prototypes, part definitions
+     * and representation items, are only read once, so the cost of this function
+     * is proportional to the number of unique entities rather than the number of
+     * instance paths.
      * \param owner A pointer to a top level object which will be traversed.
      * \param leaf_type The type of child object that should be searched for.
      * \return A set of all unique leaf entities of type \c leaf_type.
@@ -1048,6 +1476,54 @@ namespace ts3d {
      */
     static inline EntitySet getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type );
 
+    /*! \brief Used for looking up the number of instance paths leading to a given unique child.
+     * \ingroup traversal
+     */
+    using InstanceCountMap = std::unordered_map<A3DEntity*, size_t>;
+
+    /*! \brief Returns a set of \c A3DEntity pointers that are unique leaf entities and the
+     * number of instance paths referencing each child.
+     *
+     * The count stored for each entity is equal to the number of instance paths
+     * getUniqueLeafEntities( owner, leaf_type, instance_path_map ) would provide for it,
+     * but no instance path is constructed. Each unique entity is read once, and the counts
+     * are obtained by propagating the number of references through the hierarchy.
+     * \param owner A pointer to a top level object which will be traversed.
+     * \param leaf_type The type of child object that should be searched for.
+     * \param instance_counts A map containing the number of paths referencing each unique child occurrence.
+     * \return A set of all unique leaf entities of type \c leaf_type.
+     * \ingroup traversal
+     */
+    static inline EntitySet getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstanceCountMap &instance_counts );
+
+    /*! \brief Returns the number of instance paths from \c owner to leaf entities of
+     * type \c leaf_type.
+     *
+     * The result is equal to <tt>getLeafInstances( owner, leaf_type ).size()</tt>, but no
+     * instance path is constructed and each unique entity is read once.
+     * \param owner A pointer to a top level object which will be traversed.
+     * \param leaf_type The type of child object that should be counted.
+     * \return The total number of occurrences of leaf entities of type \c leaf_type.
+     * \ingroup traversal
+     */
+    static inline size_t countLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type );
+
+    /*! \brief Returns the number of instance paths from \c owner to leaf entities of
+     * type \c leaf_type and the number of paths to each unique leaf entity.
+     * \param owner A pointer to a top level object which will be traversed.
+     * \param leaf_type The type of child object that should be counted.
+     * \param instance_counts Receives the number of paths referencing each unique child occurrence.
+     * \return The total number of occurrences of leaf entities of type \c leaf_type.
+     * \sa getUniqueLeafEntities( A3DEntity *, A3DEEntityType const &, InstanceCountMap & )
+     * \ingroup traversal
+     */
+    static inline size_t countLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, InstanceCountMap &instance_counts );
+
+    /*! \brief Used for looking up the number of instance paths obtained for each leaf type.
+     * \ingroup traversal
+     */
+    using InstanceCountsByType = std::unordered_map<A3DEEntityType, size_t>;
+
     /*! \deprecated Please use getUniqueLeafEntities instead.
      */
     static inline EntitySet getUniqueChildren( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
@@ -1070,529 +1546,2759 @@ namespace ts3d {
         return getUniqueLeafEntities( owner, leaf_type, instance_path_map );
     }
 
-    /*! \brief Easily obtain a subset of an InstancePath with a final node of a specific type.
-     *  \param instance_path The instance path to obtain the parent for
-     *  \param owner_type The type of owner to search for
-     *  \return An instance path whose last object is of type \c owner_type. Or empty if to owning type is found.
-     *  \ingroup traversal
+    /*! \brief A sorted array of unique entities.
+     *
+     * This is a cache friendly alternative to EntitySet. The entities are stored
+     * contiguously in ascending order, so iteration does not chase pointers and
+     * the whole set is a single allocation. Membership is tested with a binary search.
+     * \ingroup traversal
      */
-    static inline InstancePath getOwningInstance( InstancePath const &instance_path, A3DEEntityType const &owner_type );
+    class FlatEntitySet {
+    public:
+        /*! \private */
+        using const_iterator = EntityArray::const_iterator;
 
-    /*! \brief Gets all immediate children (if any) of a specified type from a parent object
-     \param parent Object that will be queried to obtain children
-     \param child_type The types of the child objects desired
-     \return An ordered collection of child objects of type \c child_type
-     \ingroup traversal
-     */
-    static inline EntityArray getChildren( A3DEntity *parent, A3DEEntityType const &child_type );
+        /*! \brief Constructs an empty set.
+         */
+        FlatEntitySet( void ) {
+        }
 
-}
+        /*! \brief Constructs the set from an array of entities which may be unordered and contain duplicates.
+         */
+        explicit FlatEntitySet( EntityArray entities )
+        : _entities( std::move( entities ) ) {
+            std::sort( _entities.begin(), _entities.end() );
+            _entities.erase( std::unique( _entities.begin(), _entities.end() ), _entities.end() );
+        }
 
+        /*! \brief The first entity. */
+        const_iterator begin( void ) const {
+            return _entities.begin();
+        }
 
-namespace std {
-    /*! \private */
-    template <> struct hash<A3DEEntityType> {
-        size_t operator()(A3DEEntityType const& s) const noexcept {
-            return s;
+        /*! \brief Past the last entity. */
+        const_iterator end( void ) const {
+            return _entities.end();
         }
-    };
-    template<>  struct hash<ts3d::InstancePath> {
-        size_t operator()(ts3d::InstancePath const &i ) const noexcept {
-            auto seed = i.size();
-            auto const magic_number = reinterpret_cast<size_t>( A3DAsmModelFileGet );
-            for( auto &ntt : i ) {
-                seed ^= reinterpret_cast<size_t>( ntt ) + magic_number + (seed << 6) + (seed >>2 );
-            }
-            return seed;
+
+        /*! \brief The number of entities. */
+        size_t size( void ) const {
+            return _entities.size();
+        }
+
+        /*! \brief Indicates the set contains no entities. */
+        bool empty( void ) const {
+            return _entities.empty();
+        }
+
+        /*! \brief Locates \c ntt in the set, returning end() if it is not present.
+         */
+        const_iterator find( A3DEntity *ntt ) const {
+            auto const it = std::lower_bound( _entities.begin(), _entities.end(), ntt );
+            return it != _entities.end() && *it == ntt ? it : _entities.end();
+        }
+
+        /*! \brief Indicates \c ntt is present in the set.
+         */
+        bool contains( A3DEntity *ntt ) const {
+            return find( ntt ) != end();
+        }
+
+        /*! \brief The entities, in ascending order.
+         */
+        EntityArray const &entities( void ) const {
+            return _entities;
+        }
+
+        /*! \brief Converts the set to an EntitySet.
+         */
+        EntitySet toEntitySet( void ) const {
+            return EntitySet( _entities.begin(), _entities.end() );
         }
+
+        /*! \brief Two sets are equal if they contain the same entities.
+         */
+        bool operator==( FlatEntitySet const &other ) const {
+            return _entities == other._entities;
+        }
+
+        /*! \brief Negation of operator==
+         */
+        bool operator!=( FlatEntitySet const &other ) const {
+            return !(*this == other);
+        }
+
+    private:
+        EntityArray _entities;
     };
-}
 
-namespace {
-    using namespace ts3d;
-    using TypeSet = std::set<A3DEEntityType>;
-    using TypePath = std::vector<A3DEEntityType>;
-    using TypePathArray = std::vector<TypePath>;
+    /*! \brief A read only view of an instance path stored contiguously
+     * in a FlatInstancePathMap.
+     * \ingroup traversal
+     */
+    class InstancePathView {
+    public:
+        /*! \private */
+        using const_iterator = A3DEntity * const *;
 
-    // Function object that can be invoked to obtain an EntityArray
-    // of the child objects
-    using GetterFunction = std::function<EntityArray (A3DEntity*)>;
+        /*! \brief Constructs a view of the entities in [\c first, \c last).
+         */
+        InstancePathView( A3DEntity * const *first, A3DEntity * const *last )
+        : _first( first ), _last( last ) {
+        }
 
-    // The GetterMap is used to look up a getter function for a
-    // particular child object type
-    using GetterMap = std::unordered_map<A3DEEntityType, GetterFunction>;
+        /*! \brief The first entity of the path. */
+        const_iterator begin( void ) const {
+            return _first;
+        }
 
-    // The GetterMapsByType is used to look up a GetterMap for a
-    // particular owning object type
-    using GetterMapsByType = std::unordered_map<A3DEEntityType, GetterMap>;
-    
-    // This is the static instance of a GetterMapsByType. It is
-    // initialized with parent type to { child type } hash, and
-    // for each child type it contains a function object for
-    // obtaining the children of that type. See the typedef
-    // statements above to better understand the initializer
-    // syntax.
-    static GetterMapsByType _getterMapByType = {
-        {   // an entry in GetterMapsByType
-            kA3DTypeAsmModelFile, // A3DEEntityType (owning object type)
-            { // GetterMap
-                { // an entry in GetterMap
-                    kA3DTypeAsmProductOccurrence, // A3DEEntityType (child object type)
-                    [](A3DEntity *ntt) {          // GetteFunction (function for getting children)
-                        A3DAsmModelFileWrapper d( ntt );
-                        return toVector( d->m_ppPOccurrences, d->m_uiPOccurrencesSize );
-                    }
+        /*! \brief Past the last entity of the path. */
+        const_iterator end( void ) const {
+            return _last;
+        }
+
+        /*! \brief The number of entities in the path. */
+        size_t size( void ) const {
+            return static_cast<size_t>( _last - _first );
+        }
+
+        /*! \brief Gets the entity at position \c idx. */
+        A3DEntity *operator[]( size_t const idx ) const {
+            return _first[idx];
+        }
+
+        /*! \brief The first entity of the path. */
+        A3DEntity *front( void ) const {
+            return *_first;
+        }
+
+        /*! \brief The leaf entity of the path. */
+        A3DEntity *back( void ) const {
+            return *(_last - 1);
+        }
+
+        /*! \brief Copies the view into an InstancePath.
+         */
+        InstancePath path( void ) const {
+            return InstancePath( _first, _last );
+        }
+
+    private:
+        A3DEntity * const *_first;
+        A3DEntity * const *_last;
+    };
+
+    /*! \brief A cache friendly alternative to InstancePathMap.
+     *
+     * The instance paths are stored in compressed sparse row form: the entities
+     * of all paths are held in one contiguous array, in the order the paths were
+     * provided, with an array of offsets delimiting the paths. The paths are
+     * grouped by leaf entity through an array of path indexes ordered by leaf,
+     * delimited by one offset per leaf entity. The map consists of five arrays
+     * regardless of the number of paths. The entity and path offset arrays grow
+     * as the paths are produced, the others are allocated once at their final
+     * size.
+     * \code
+     * ts3d::FlatInstancePathMap instance_path_map;
+     * auto const parts = ts3d::getUniqueLeafEntitiesFlat( model_file, kA3DTypeAsmPartDefinition, instance_path_map );
+     * for( auto const part : parts ) {
+     *     for( auto idx = 0u; idx < instance_path_map.pathCount( part ); ++idx ) {
+     *         auto const part_path = instance_path_map.path( part, idx );
+     *         // ...
+     *     }
+     * }
+     * \endcode
+     * \ingroup traversal
+     */
+    class FlatInstancePathMap {
+    public:
+        /*! \brief Constructs an empty map.
+         */
+        FlatInstancePathMap( void ) {
+        }
+
+        /*! \brief Constructs the map from a range of instance paths, such as an
+         * InstancePathArray or the range returned by leafInstances(). The paths
+         * are copied directly into the map as they are produced. The order of the
+         * paths for each leaf entity is preserved.
+         */
+        template<typename InstancePathRange>
+        explicit FlatInstancePathMap( InstancePathRange const &instance_paths ) {
+            _path_offsets.push_back( 0u );
+            for( auto const &instance_path : instance_paths ) {
+                if( !instance_path.empty() ) {
+                    _entities.insert( _entities.end(), instance_path.begin(), instance_path.end() );
+                    _path_offsets.push_back( _entities.size() );
                 }
             }
-        },
-        {
-            kA3DTypeAsmProductOccurrence,
-            {
-                {
-                    kA3DTypeAsmProductOccurrence,
-                    [](A3DEntity *ntt) {
-                        return getProductOccurrences( ntt, PrototypeOption::Use );
-                    }
-                },
-                {
-                    kA3DTypeAsmPartDefinition,
-                    [](A3DEntity *ntt) {
-                        auto const part_definition = getPartDefinition( ntt, PrototypeOption::Use );
-                        return nullptr == part_definition ? EntityArray() : EntityArray( 1, part_definition );
-                    }
-                },
-                {
-                    kA3DTypeMkpView,
-                    [](A3DEntity *ntt) {
-                        A3DAsmProductOccurrenceWrapper d( ntt );
-                        return toVector( d->m_ppViews, d->m_uiViewsSize );
-                    }
-                },
-                {
-                    kA3DTypeGraphCamera,
-                    [](A3DEntity *ntt) {
-                        A3DAsmProductOccurrenceWrapper d( ntt );
-                        return toVector( d->m_ppCamera, d->m_uiCameraSize );
-                    }
-                },
+
+            auto const path_count = _path_offsets.size() - 1u;
+            _path_order.resize( path_count );
+            for( auto path_idx = size_t( 0u ); path_idx < path_count; ++path_idx ) {
+                _path_order[path_idx] = path_idx;
+            }
+            // Ties are broken by path index, which keeps the order of the paths
+            // for each leaf without the temporary buffer of std::stable_sort.
+            std::sort( _path_order.begin(), _path_order.end(), [this]( size_t const lhs, size_t const rhs ) {
+                auto const lhs_leaf = leafOf( lhs );
+                auto const rhs_leaf = leafOf( rhs );
+                return lhs_leaf < rhs_leaf || (lhs_leaf == rhs_leaf && lhs < rhs);
+            });
+
+            // Count the unique leaf entities to size the key arrays exactly.
+            auto key_count = size_t( 0u );
+            for( auto order_idx = size_t( 0u ); order_idx < path_count; ++order_idx ) {
+                if( 0u == order_idx || leafOf( _path_order[order_idx - 1u] ) != leafOf( _path_order[order_idx] ) ) {
+                    ++key_count;
+                }
+            }
+            _keys.reserve( key_count );
+            _key_offsets.reserve( key_count + 1u );
+            for( auto order_idx = size_t( 0u ); order_idx < path_count; ++order_idx ) {
+                auto const leaf = leafOf( _path_order[order_idx] );
+                if( _keys.empty() || _keys.back() != leaf ) {
+                    _keys.push_back( leaf );
+                    _key_offsets.push_back( order_idx );
+                }
+            }
+            _key_offsets.push_back( path_count );
+            TS3D_INSTRUMENT( Instrumentation::recordPathBytes( (_entities.capacity() + _keys.capacity()) * sizeof( A3DEntity* ) + (_path_offsets.capacity() + _path_order.capacity() + _key_offsets.capacity()) * sizeof( size_t ) ) );
+        }
+
+        /*! \brief The unique leaf entities, in ascending order.
+         */
+        EntityArray const &keys( void ) const {
+            return _keys;
+        }
+
+        /*! \brief The number of unique leaf entities.
+         */
+        size_t size( void ) const {
+            return _keys.size();
+        }
+
+        /*! \brief The total number of instance paths.
+         */
+        size_t pathCount( void ) const {
+            return _path_order.size();
+        }
+
+        /*! \brief The number of instance paths leading to \c leaf, zero if it is not present.
+         */
+        size_t pathCount( A3DEntity *leaf ) const {
+            auto const key_idx = indexOf( leaf );
+            return key_idx < _keys.size() ? _key_offsets[key_idx + 1u] - _key_offsets[key_idx] : 0u;
+        }
+
+        /*! \brief Gets the instance path at position \c idx of those leading to \c leaf.
+         * \throw std::out_of_range if \c leaf is not present or \c idx is not less than pathCount( leaf ).
+         */
+        InstancePathView path( A3DEntity *leaf, size_t const idx ) const {
+            auto const key_idx = indexOf( leaf );
+            if( key_idx >= _keys.size() || idx >= _key_offsets[key_idx + 1u] - _key_offsets[key_idx] ) {
+                throw std::out_of_range( "Instance path index out of range." );
+            }
+            return pathView( _path_order[_key_offsets[key_idx] + idx] );
+        }
+
+        /*! \brief Copies the instance paths leading to \c leaf into an InstancePathArray.
+         */
+        InstancePathArray paths( A3DEntity *leaf ) const {
+            InstancePathArray result;
+            auto const key_idx = indexOf( leaf );
+            if( key_idx < _keys.size() ) {
+                appendPaths( key_idx, result );
+            }
+            return result;
+        }
+
+        /*! \brief Appends the instance paths for each leaf entity to the corresponding entry of \c instance_path_map.
+         */
+        void appendTo( InstancePathMap &instance_path_map ) const {
+            for( auto key_idx = size_t( 0u ); key_idx < _keys.size(); ++key_idx ) {
+                appendPaths( key_idx, instance_path_map[_keys[key_idx]] );
+            }
+        }
+
+        /*! \brief Converts the map to an InstancePathMap.
+         */
+        InstancePathMap toInstancePathMap( void ) const {
+            InstancePathMap result;
+            appendTo( result );
+            return result;
+        }
+
+    private:
+        size_t indexOf( A3DEntity *leaf ) const {
+            auto const it = std::lower_bound( _keys.begin(), _keys.end(), leaf );
+            return it != _keys.end() && *it == leaf ? static_cast<size_t>( it - _keys.begin() ) : _keys.size();
+        }
+
+        A3DEntity *leafOf( size_t const path_idx ) const {
+            return _entities[_path_offsets[path_idx + 1u] - 1u];
+        }
+
+        InstancePathView pathView( size_t const path_idx ) const {
+            return InstancePathView( _entities.data() + _path_offsets[path_idx], _entities.data() + _path_offsets[path_idx + 1u] );
+        }
+
+        void appendPaths( size_t const key_idx, InstancePathArray &instance_paths ) const {
+            instance_paths.reserve( instance_paths.size() + _key_offsets[key_idx + 1u] - _key_offsets[key_idx] );
+            for( auto order_idx = _key_offsets[key_idx]; order_idx < _key_offsets[key_idx + 1u]; ++order_idx ) {
+                instance_paths.push_back( pathView( _path_order[order_idx] ).path() );
+            }
+        }
+
+        EntityArray _keys;
+        std::vector<size_t> _key_offsets;
+        std::vector<size_t> _path_order;
+        std::vector<size_t> _path_offsets;
+        EntityArray _entities;
+    };
+
+    /*! \brief Variation of getUniqueLeafEntities() that returns a FlatEntitySet.
+     * \ingroup traversal
+     */
+    static inline FlatEntitySet getUniqueLeafEntitiesFlat( A3DEntity *owner, A3DEEntityType const &leaf_type );
+
+    /*! \brief Variation of getUniqueLeafEntities() that returns a FlatEntitySet and
+     * provides the instance paths to each unique leaf entity in a FlatInstancePathMap.
+     * \param owner A pointer to a top level object which will be traversed.
+     * \param leaf_type The type of child object that should be searched for.
+     * \param instance_path_map Receives the paths referencing each unique child occurrence. Any previous content is replaced.
+     * \return A set of all unique leaf entities of type \c leaf_type.
+     * \ingroup traversal
+     */
+    static inline FlatEntitySet getUniqueLeafEntitiesFlat( A3DEntity *owner, A3DEEntityType const &leaf_type, FlatInstancePathMap &instance_path_map );
+
+    /*! \brief A compact handle referencing an instance path stored in an InstancePathTree.
+     * \ingroup traversal
+     */
+    using InstancePathHandle = A3DUns32;
+
+    /*! \brief Used as a collection of InstancePathHandle objects.
+     * \ingroup traversal
+     */
+    using InstancePathHandleArray = std::vector<InstancePathHandle>;
+
+    /*! \brief Used for looking up the instance path handles for a given unique child.
+     * \ingroup traversal
+     */
+    using InstancePathHandleMap = std::unordered_map<A3DEntity*, InstancePathHandleArray>;
+
+    /*! \brief Compact storage for a large number of instance paths.
+     *
+     * Instance paths produced by traversal typically share long prefixes. For example,
+     * all faces of a body share the model file, product occurrence, part definition,
+     * representation item, B-Rep data, connex and shell entries. The InstancePathTree
+     * stores each distinct prefix exactly once as a node containing an entity and the
+     * handle of its parent node. An instance path is then represented by the
+     * InstancePathHandle of its final node, and can be expanded into an InstancePath
+     * on demand.
+     * \code
+     * ts3d::InstancePathTree tree;
+     * auto const face_handles = ts3d::getLeafInstances( model_file, kA3DTypeTopoFace, tree );
+     * for( auto const face_handle : face_handles ) {
+     *     ts3d::Instance face_instance( tree, face_handle );
+     *     // ...
+     * }
+     * \endcode
+     * \ingroup traversal
+     */
+    class InstancePathTree {
+    public:
+        /*! \brief The handle value used to indicate no node, such as the parent of a root node.
+         */
+        static InstancePathHandle invalidHandle( void ) {
+            return ~InstancePathHandle( 0u );
+        }
+
+        /*! \brief Adds a node to the tree.
+         * \param parent The handle of the parent node, or invalidHandle() for a root node.
+         * \param ntt The entity referenced by the new node.
+         * \return The handle of the new node.
+         */
+        InstancePathHandle add( InstancePathHandle const parent, A3DEntity *ntt ) {
+            if( _nodes.size() >= invalidHandle() ) {
+                throw std::length_error( "Instance path tree node limit exceeded." );
+            }
+            auto const depth = invalidHandle() == parent ? 1u : _nodes[parent]._depth + 1u;
+            _nodes.push_back( { ntt, parent, depth } );
+            return static_cast<InstancePathHandle>( _nodes.size() - 1u );
+        }
+
+        /*! \brief Adds the nodes required to represent \c instance_path, reusing
+         * the nodes of the previously added path where their prefixes are identical.
+         * Paths produced by a depth first traversal share as much storage as possible
+         * when added in traversal order.
+         * \return The handle of the node for the last entity of \c instance_path.
+         */
+        InstancePathHandle add( InstancePath const &instance_path ) {
+            auto common = 0u;
+            while( common < instance_path.size() && common < _last_path_nodes.size() && _nodes[_last_path_nodes[common]]._ntt == instance_path[common] ) {
+                ++common;
+            }
+            _last_path_nodes.resize( common );
+            for( auto idx = common; idx < instance_path.size(); ++idx ) {
+                auto const parent = 0u == idx ? invalidHandle() : _last_path_nodes.back();
+                _last_path_nodes.push_back( add( parent, instance_path[idx] ) );
+            }
+            return _last_path_nodes.empty() ? invalidHandle() : _last_path_nodes.back();
+        }
+
+        /*! \brief Gets the entity referenced by the node.
+         */
+        A3DEntity *entity( InstancePathHandle const handle ) const {
+            return _nodes[handle]._ntt;
+        }
+
+        /*! \brief Gets the handle of the parent node, or invalidHandle() for a root node.
+         */
+        InstancePathHandle parent( InstancePathHandle const handle ) const {
+            return _nodes[handle]._parent;
+        }
+
+        /*! \brief Gets the number of entities in the instance path ending with this node.
+         */
+        A3DUns32 depth( InstancePathHandle const handle ) const {
+            return _nodes[handle]._depth;
+        }
+
+        /*! \brief Expands the handle into \c instance_path. The storage of
+         * \c instance_path is reused.
+         */
+        void expand( InstancePathHandle handle, InstancePath &instance_path ) const {
+            if( invalidHandle() == handle ) {
+                instance_path.clear();
+                return;
+            }
+            instance_path.resize( _nodes[handle]._depth );
+            for( auto idx = instance_path.size(); idx > 0u; --idx ) {
+                instance_path[idx - 1u] = _nodes[handle]._ntt;
+                handle = _nodes[handle]._parent;
+            }
+        }
+
+        /*! \brief Expands the handle into an InstancePath.
+         */
+        InstancePath expand( InstancePathHandle const handle ) const {
+            InstancePath result;
+            expand( handle, result );
+            return result;
+        }
+
+        /*! \brief The number of nodes in the tree.
+         */
+        size_t size( void ) const {
+            return _nodes.size();
+        }
+
+        /*! \brief Reserves storage for \c node_count nodes.
+         */
+        void reserve( size_t const node_count ) {
+            _nodes.reserve( node_count );
+        }
+
+        /*! \brief Removes all nodes. All handles become invalid.
+         */
+        void clear( void ) {
+            _nodes.clear();
+            _last_path_nodes.clear();
+        }
+
+    private:
+        struct Node {
+            A3DEntity *_ntt;
+            InstancePathHandle _parent;
+            A3DUns32 _depth;
+        };
+        std::vector<Node> _nodes;
+        std::vector<InstancePathHandle> _last_path_nodes;
+    };
+
+    /*! \brief Variation of getLeafInstances() that stores the instance paths in
+     * \c tree rather than as individual arrays.
+     * \param owner The top level object to begin traversal.
+     * \param leaf_type The type of child node to look for.
+     * \param tree The tree into which the instance paths are added.
+     * \return The handles of the instance paths, in the same order as getLeafInstances().
+     * \ingroup traversal
+     */
+    static inline InstancePathHandleArray getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathTree &tree );
+
+    /*! \brief Variation of getUniqueLeafEntities() that stores the instance paths
+     * in \c tree rather than as individual arrays.
+     * \param owner A pointer to a top level object which will be traversed.
+     * \param leaf_type The type of child object that should be searched for.
+     * \param tree The tree into which the instance paths are added.
+     * \param instance_path_map A map containing the handles for all paths referencing each unique child occurrence.
+     * \ingroup traversal
+     */
+    static inline EntitySet getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathTree &tree, InstancePathHandleMap &instance_path_map );
+
+    /*! \brief Assigns a unique, dense, 32 bit handle to each distinct instance path.
+     *
+     * Unlike an InstancePathTree, which stores every path that is added, a
+     * PathInterner stores each distinct path once. Two handles obtained from the
+     * same interner are equal if and only if the paths they reference are equal,
+     * so handles can be hashed and compared in constant time and used in place of
+     * InstancePath values as keys of containers. Handles are assigned in increasing
+     * order starting from zero, so they can also be used to index arrays.
+     * \code
+     * ts3d::PathInterner interner;
+     * auto const ri_handles = ts3d::getLeafInstances( model_file, kA3DTypeRiRepresentationItem, interner );
+     * std::vector<double> areas( interner.size() );
+     * for( auto const ri_handle : ri_handles ) {
+     *     areas[ri_handle] = computeArea( ts3d::Instance( interner.tree(), ri_handle ) );
+     * }
+     * \endcode
+     * The parent, depth and leaf entity of a handle are available in constant time.
+     *
+     * CascadedAttributesCache and NetMatrixCache key their entries on handles.
+     * The traversal functions taking a PathInterner return handles, and
+     * getUniqueLeafEntities() can fill an InstancePathHandleMap rather than an
+     * InstancePathMap. An Instance constructed from an interner and a handle is
+     * compared with other instances of the same interner by handle. Prefer these
+     * to InstancePath keys, whose hash and comparison visit every entity.
+     * \ingroup traversal
+     */
+    class PathInterner {
+    public:
+        /*! \brief The handle value used to indicate no path. \sa InstancePathTree::invalidHandle
+         */
+        static InstancePathHandle invalidHandle( void ) {
+            return InstancePathTree::invalidHandle();
+        }
+
+        /*! \brief Obtains the handle of the path formed by appending \c ntt to the path
+         * referenced by \c parent, assigning a new handle if the path has not been seen before.
+         * \param parent The handle of the parent path, or invalidHandle() for a path containing only \c ntt.
+         * \param ntt The last entity of the path.
+         */
+        InstancePathHandle intern( InstancePathHandle const parent, A3DEntity *ntt ) {
+            auto const result = _handles.emplace( Key( parent, ntt ), invalidHandle() );
+            if( result.second ) {
+                try {
+                    result.first->second = _tree.add( parent, ntt );
+                } catch( ... ) {
+                    _handles.erase( result.first );
+                    throw;
+                }
+            }
+            return result.first->second;
+        }
+
+        /*! \brief Obtains the handle of \c instance_path, assigning new handles to it and
+         * any of its prefixes that have not been seen before. Paths that share a prefix with
+         * the previously interned path, as is typical of paths produced by traversal, are
+         * interned without looking up the shared prefix.
+         */
+        InstancePathHandle intern( InstancePath const &instance_path ) {
+            auto common = 0u;
+            while( common < instance_path.size() && common < _last_path_handles.size() && _tree.entity( _last_path_handles[common] ) == instance_path[common] ) {
+                ++common;
+            }
+            _last_path_handles.resize( common );
+            for( auto idx = common; idx < instance_path.size(); ++idx ) {
+                auto const parent = 0u == idx ? invalidHandle() : _last_path_handles.back();
+                _last_path_handles.push_back( intern( parent, instance_path[idx] ) );
+            }
+            return _last_path_handles.empty() ? invalidHandle() : _last_path_handles.back();
+        }
+
+        /*! \brief Gets the handle of the path formed by appending \c ntt to the path
+         * referenced by \c parent, or invalidHandle() if it has not been interned.
+         */
+        InstancePathHandle find( InstancePathHandle const parent, A3DEntity *ntt ) const {
+            auto const it = _handles.find( Key( parent, ntt ) );
+            return std::end( _handles ) == it ? invalidHandle() : it->second;
+        }
+
+        /*! \brief Gets the handle of \c instance_path, or invalidHandle() if it has not been interned.
+         */
+        InstancePathHandle find( InstancePath const &instance_path ) const {
+            auto handle = invalidHandle();
+            for( auto const ntt : instance_path ) {
+                handle = find( handle, ntt );
+                if( invalidHandle() == handle ) {
+                    break;
+                }
+            }
+            return handle;
+        }
+
+        /*! \brief Gets the last entity of the path.
+         */
+        A3DEntity *leaf( InstancePathHandle const handle ) const {
+            return _tree.entity( handle );
+        }
+
+        /*! \brief Gets the handle of the path without its last entity, or invalidHandle()
+         * if the path contains a single entity.
+         */
+        InstancePathHandle parent( InstancePathHandle const handle ) const {
+            return _tree.parent( handle );
+        }
+
+        /*! \brief Gets the number of entities in the path.
+         */
+        A3DUns32 depth( InstancePathHandle const handle ) const {
+            return _tree.depth( handle );
+        }
+
+        /*! \brief Expands the handle into \c instance_path. The storage of
+         * \c instance_path is reused.
+         */
+        void expand( InstancePathHandle const handle, InstancePath &instance_path ) const {
+            _tree.expand( handle, instance_path );
+        }
+
+        /*! \brief Expands the handle into an InstancePath.
+         */
+        InstancePath expand( InstancePathHandle const handle ) const {
+            return _tree.expand( handle );
+        }
+
+        /*! \brief The number of distinct paths interned, including prefixes.
+         * All handles are less than this value.
+         */
+        size_t size( void ) const {
+            return _tree.size();
+        }
+
+        /*! \brief The tree containing the interned paths. Handles obtained from the
+         * interner can be used with it, for example to construct an Instance.
+         */
+        InstancePathTree const &tree( void ) const {
+            return _tree;
+        }
+
+        /*! \brief Removes all paths. All handles become invalid.
+         */
+        void clear( void ) {
+            _tree.clear();
+            _handles.clear();
+            _last_path_handles.clear();
+        }
+
+    private:
+        using Key = std::pair<InstancePathHandle, A3DEntity*>;
+        struct KeyHash {
+            size_t operator()( Key const &key ) const noexcept {
+                return std::hash<A3DEntity*>()( key.second ) ^ (static_cast<size_t>( key.first ) * 0x9e3779b9u);
+            }
+        };
+
+        InstancePathTree _tree;
+        std::unordered_map<Key, InstancePathHandle, KeyHash> _handles;
+        InstancePathHandleArray _last_path_handles;
+    };
+
+    /*! \brief Variation of getLeafInstances() that interns the instance paths
+     * in \c interner rather than returning them as individual arrays.
+     * \param owner The top level object to begin traversal.
+     * \param leaf_type The type of child node to look for.
+     * \param interner The interner into which the instance paths are added.
+     * \return The handles of the instance paths, in the same order as getLeafInstances().
+     * \ingroup traversal
+     */
+    static inline InstancePathHandleArray getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, PathInterner &interner );
+
+    /*! \brief Variation of getUniqueLeafEntities() that interns the instance paths
+     * in \c interner rather than storing them as individual arrays.
+     * \param owner A pointer to a top level object which will be traversed.
+     * \param leaf_type The type of child object that should be searched for.
+     * \param interner The interner into which the instance paths are added.
+     * \param instance_path_map A map containing the handles for all paths referencing each unique child occurrence.
+     * \ingroup traversal
+     */
+    static inline EntitySet getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, PathInterner &interner, InstancePathHandleMap &instance_path_map );
+
+    /*! \brief Easily obtain a subset of an InstancePath with a final node of a specific type.
+     *  \param instance_path The instance path to obtain the parent for
+     *  \param owner_type The type of owner to search for
+     *  \return An instance path whose last object is of type \c owner_type. Or empty if to owning type is found.
+     *  \ingroup traversal
+     */
+    static inline InstancePath getOwningInstance( InstancePath const &instance_path, A3DEEntityType const &owner_type );
+
+    /*! \brief Gets all immediate children (if any) of a specified type from a parent object
+     \param parent Object that will be queried to obtain children
+     \param child_type The types of the child objects desired
+     \return An ordered collection of child objects of type \c child_type
+     \ingroup traversal
+     */
+    static inline EntityArray getChildren( A3DEntity *parent, A3DEEntityType const &child_type );
+
+    /*! \brief Value returned by traversal callbacks to control how the traversal proceeds.
+     * \ingroup traversal
+     */
+    enum class TraversalAction {
+        /*! \brief Keep going. */
+        Continue,
+        /*! \brief Do not descend into the current node. Neither the node nor any of its children are reported as leaf instances. */
+        SkipSubtree,
+        /*! \brief Terminate the traversal immediately. */
+        Stop
+    };
+
+    /*! \brief Callback type used during traversal. The argument is the instance
+     * path of the node currently being visited.
+     * \ingroup traversal
+     */
+    using TraversalCallback = std::function<TraversalAction( InstancePath const & )>;
+
+    /*! \brief Traverses \c owner looking for leaf entities of type \c leaf_type,
+     * allowing the caller to prune entire subtrees during descent.
+     *
+     * \c node_cb is invoked once for each node the traversal reaches, before any
+     * of its children are fetched. Returning TraversalAction::SkipSubtree prevents
+     * everything below the node from being visited. This is much cheaper than
+     * filtering the result of getLeafInstances() after the fact, since the pruned
+     * portion of the hierarchy is never read. \c leaf_cb is invoked for each
+     * instance path whose leaf entity is of type \c leaf_type, in depth first order.
+     * This is the order of getLeafInstances(), unless more than one sequence of types
+     * leads from \c owner to \c leaf_type. Markup, for example, is found below both
+     * product occurrences and part definitions. Each node is still visited once,
+     * and the paths of the different type sequences are interleaved.
+     *
+     * The following snippet gathers all representation items while ignoring product
+     * occurrences that are removed.
+     * \code
+     * ts3d::InstancePathArray ris;
+     * ts3d::visitLeafInstances( model_file, kA3DTypeRiRepresentationItem,
+     *     []( ts3d::InstancePath const &path ) {
+     *         if( kA3DTypeAsmProductOccurrence == ts3d::getEntityType( path.back() ) && ts3d::Instance( path ).getNetRemoved() ) {
+     *             return ts3d::TraversalAction::SkipSubtree;
+     *         }
+     *         return ts3d::TraversalAction::Continue;
+     *     },
+     *     [&ris]( ts3d::InstancePath const &path ) {
+     *         ris.push_back( path );
+     *         return ts3d::TraversalAction::Continue;
+     *     } );
+     * \endcode
+     * \param owner The top level object to begin traversal.
+     * \param leaf_type The type of child node to look for.
+     * \param node_cb Invoked for every node reached, may be empty.
+     * \param leaf_cb Invoked for every leaf instance. Returning TraversalAction::Stop terminates the traversal.
+     * \return \c false if the traversal was terminated by a callback, \c true otherwise.
+     * \ingroup traversal
+     */
+    static inline bool visitLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCallback const &node_cb, TraversalCallback const &leaf_cb );
+
+    /*! \brief Parallel variant of getLeafInstances().
+     *
+     * Each product occurrence is traversed by a separate task. The content below
+     * it (part definitions, representation items, B-Rep, markup, etc.) is read by
+     * the task, and the tasks for its child product occurrences are spawned as they
+     * are reached. Tasks are executed by the calling thread together with threads
+     * of a pool that persists between calls. Results are merged such that the
+     * returned array is identical, in content and order, to the result of
+     * getLeafInstances().
+     *
+     * The Exchange API must permit concurrent calls to \c Get functions. If it does
+     * not, define \c TS3D_SERIALIZE_API_CALLS so that the calls are serialized,
+     * see ApiLock. The achievable speed up is then bounded by the time spent
+     * outside of Exchange.
+     * \param owner The top level object to begin traversal.
+     * \param leaf_type The type of child node to look for.
+     * \param thread_count The number of threads to use. If zero, \c std::thread::hardware_concurrency() is used.
+     * \ingroup traversal
+     */
+    static inline InstancePathArray getLeafInstancesParallel( A3DEntity *owner, A3DEEntityType const &leaf_type, unsigned int thread_count = 0u );
+
+    /*! \brief Parallel variant of getUniqueLeafEntities().
+     * Instance paths are not stored, and a product occurrence reached along more
+     * than one instance path is traversed once.
+     * \sa getLeafInstancesParallel
+     * \ingroup traversal
+     */
+    static inline EntitySet getUniqueLeafEntitiesParallel( A3DEntity *owner, A3DEEntityType const &leaf_type, unsigned int thread_count = 0u );
+
+    /*! \brief Parallel variant of getUniqueLeafEntities() that also provides the
+     * instance paths to each unique leaf entity. The instance paths for each entity
+     * are in the same order as those produced by getUniqueLeafEntities().
+     * \sa getLeafInstancesParallel
+     * \ingroup traversal
+     */
+    static inline EntitySet getUniqueLeafEntitiesParallel( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathMap &instance_path_map, unsigned int thread_count = 0u );
+
+    /*! \brief A collection of entity types.
+     * \ingroup traversal
+     */
+    using EntityTypeArray = std::vector<A3DEEntityType>;
+
+    /*! \brief Used for looking up the instance paths obtained for each leaf type.
+     * See getLeafInstances( A3DEntity *, EntityTypeArray const & )
+     * \ingroup traversal
+     */
+    using InstancePathsByType = std::unordered_map<A3DEEntityType, InstancePathArray>;
+
+    /*! \brief Returns the instance paths to leaf entities of several types using
+     * a single traversal of \c owner.
+     *
+     * The type paths leading to each of the requested leaf types are merged, so
+     * entities shared by more than one of them, such as product occurrences and part
+     * definitions, are read once rather than once per leaf type. The array stored for
+     * each leaf type is identical, in content and order, to the result of
+     * getLeafInstances( owner, leaf_type ).
+     * \param owner The top level object to begin traversal.
+     * \param leaf_types The types of child nodes to look for.
+     * \return The instance paths keyed by leaf type. Each of the requested types is
+     * present, even when no instances were found.
+     * \ingroup traversal
+     */
+    static inline InstancePathsByType getLeafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types );
+
+    /*! \brief Returns the number of instance paths from \c owner to leaf entities of
+     * each of the types in \c leaf_types, using a single traversal in which each unique
+     * entity is read once.
+     * \param owner The top level object to begin traversal.
+     * \param leaf_types The types of child nodes to count.
+     * \return The number of occurrences keyed by leaf type. Each of the requested types is present.
+     * \ingroup traversal
+     */
+    static inline InstanceCountsByType countLeafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types );
+
+    class TraversalCache;
+
+    /*! \brief Variation of getChildren() that reads the children from \c cache when
+     * they have previously been obtained, and stores them in \c cache otherwise.
+     * \ingroup traversal
+     */
+    static inline EntityArray getChildren( A3DEntity *parent, A3DEEntityType const &child_type, TraversalCache &cache );
+
+    /*! \brief Variation of getLeafInstances() that obtains the children of each entity
+     * visited from \c cache, reading them from Exchange only the first time they are needed.
+     *
+     * The result is identical to getLeafInstances( owner, leaf_type ). Reusing the same
+     * cache for subsequent calls on the same model avoids reading any entity twice.
+     * \sa TraversalCache
+     * \ingroup traversal
+     */
+    static inline InstancePathArray getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCache &cache );
+
+    /*! \brief Variation of getUniqueLeafEntities() that uses \c cache to avoid
+     * reading the same entities from Exchange more than once. \sa TraversalCache
+     * \ingroup traversal
+     */
+    static inline EntitySet getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCache &cache );
+
+    /*! \brief Variation of getUniqueLeafEntities() that also provides the instance
+     * paths to each unique leaf entity and uses \c cache to avoid reading the same
+     * entities from Exchange more than once. \sa TraversalCache
+     * \ingroup traversal
+     */
+    static inline EntitySet getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathMap &instance_path_map, TraversalCache &cache );
+}
+
+
+namespace std {
+    /*! \private */
+    template <> struct hash<A3DEEntityType> {
+        size_t operator()(A3DEEntityType const& s) const noexcept {
+            return s;
+        }
+    };
+    template<>  struct hash<ts3d::InstancePath> {
+        size_t operator()(ts3d::InstancePath const &i ) const noexcept {
+            auto seed = i.size();
+            auto const magic_number = size_t( 0x9e3779b9u );
+            for( auto &ntt : i ) {
+                seed ^= reinterpret_cast<size_t>( ntt ) + magic_number + (seed << 6) + (seed >>2 );
+            }
+            return seed;
+        }
+    };
+}
+
+namespace ts3d {
+    /*! \private
+     * \brief Threads shared by the parallel functions of the toolkit. Threads are
+     * created as they are first needed and are joined when the program exits.
+     */
+    class WorkerPool {
+    public:
+        static WorkerPool &instance( void ) {
+            static WorkerPool pool;
+            return pool;
+        }
+
+        /*! \brief Queues \c job to be run by a pool thread, first growing the
+         * pool to \c thread_count threads if it is smaller.
+         */
+        void submit( std::function<void( void )> job, size_t const thread_count ) {
+            std::lock_guard<std::mutex> const lock( _mutex );
+            while( _threads.size() < thread_count ) {
+                _threads.emplace_back( [this]() {
+                    work();
+                });
+            }
+            _jobs.push_back( std::move( job ) );
+            _cv.notify_one();
+        }
+
+        ~WorkerPool( void ) {
+            {
+                std::lock_guard<std::mutex> const lock( _mutex );
+                _stopping = true;
+            }
+            _cv.notify_all();
+            for( auto &thread : _threads ) {
+                thread.join();
+            }
+        }
+
+    private:
+        WorkerPool( void ) {
+        }
+        WorkerPool( WorkerPool const &other ) = delete;
+        WorkerPool &operator=( WorkerPool const &other ) = delete;
+
+        void work( void ) {
+            std::unique_lock<std::mutex> lock( _mutex );
+            while( true ) {
+                _cv.wait( lock, [this]() {
+                    return _stopping || !_jobs.empty();
+                });
+                if( _jobs.empty() ) {
+                    return;
+                }
+                auto job = std::move( _jobs.front() );
+                _jobs.pop_front();
+                lock.unlock();
+                job();
+                job = nullptr;
+                lock.lock();
+            }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::deque<std::function<void( void )>> _jobs;
+        std::vector<std::thread> _threads;
+        bool _stopping = false;
+    };
+
+    /*! \private
+     * \brief A set of tasks executed by the thread calling wait() together with
+     * up to \c thread_count - 1 threads of the WorkerPool. Tasks may spawn further
+     * tasks. Pool threads only join the group if it is still running when they
+     * become available, so groups can be nested without the risk of deadlock.
+     * The first exception thrown by a task is rethrown by wait(), and tasks that
+     * have not started by then are discarded.
+     *
+     * Each participating thread has its own queue. A task spawned from within a
+     * task is pushed onto the queue of the thread running it, and threads take
+     * tasks from the back of their own queue. A thread whose queue is empty
+     * steals from the front of the other queues, so the queues are only
+     * contended while work is being redistributed.
+     */
+    class TaskGroup {
+    public:
+        using Task = std::function<void( void )>;
+
+        explicit TaskGroup( unsigned int const thread_count )
+        : _thread_count( 0u == thread_count ? std::max( 1u, std::thread::hardware_concurrency() ) : thread_count ) {
+            _state = std::make_shared<State>( _thread_count );
+        }
+
+        /*! \brief Adds a task to the group. Can be called from within a task.
+         */
+        void spawn( Task task ) {
+            _state->push( std::move( task ) );
+        }
+
+        /*! \brief Runs tasks on the calling thread until all of them are complete.
+         */
+        void wait( void ) {
+            auto const state = _state;
+            for( auto helper = 1u; helper < _thread_count; ++helper ) {
+                WorkerPool::instance().submit( [state]() {
+                    {
+                        std::lock_guard<std::mutex> const lock( state->_idle_mutex );
+                        if( state->_closed ) {
+                            return;
+                        }
+                        ++state->_helpers;
+                    }
+                    state->work( state->_next_slot++ );
+                    std::lock_guard<std::mutex> const lock( state->_idle_mutex );
+                    --state->_helpers;
+                    state->_idle_cv.notify_all();
+                }, _thread_count - 1u );
+            }
+
+            state->work( 0u );
+            std::unique_lock<std::mutex> lock( state->_idle_mutex );
+            state->_closed = true;
+            state->_idle_cv.wait( lock, [&state]() {
+                return 0u == state->_helpers;
+            });
+            if( state->_exception ) {
+                std::rethrow_exception( state->_exception );
+            }
+        }
+
+    private:
+        TaskGroup( TaskGroup const &other ) = delete;
+        TaskGroup &operator=( TaskGroup const &other ) = delete;
+
+        struct WorkQueue {
+            std::mutex _mutex;
+            std::deque<Task> _tasks;
+        };
+
+        // Shared with the pool threads, which can outlive the group
+        struct State {
+            explicit State( size_t const thread_count )
+            : _queues( thread_count ) {
+            }
+
+            std::vector<WorkQueue> _queues;
+            std::atomic<size_t> _next_slot{ 1u };
+            // Tasks spawned but not yet complete, and tasks waiting in a queue
+            std::atomic<size_t> _pending{ 0u };
+            std::atomic<size_t> _queued{ 0u };
+            std::atomic<bool> _failed{ false };
+
+            // Guards the remaining members, and is used by threads waiting for work
+            std::mutex _idle_mutex;
+            std::condition_variable _idle_cv;
+            std::atomic<size_t> _sleepers{ 0u };
+            size_t _helpers = 0u;
+            bool _closed = false;
+            std::exception_ptr _exception;
+
+            // The group and queue of the task running on this thread, so tasks
+            // spawned by it go to the queue of the thread that will likely run them
+            struct Current {
+                State const *_state;
+                size_t _slot;
+            };
+            static Current &current( void ) {
+                static thread_local Current _current = { nullptr, 0u };
+                return _current;
+            }
+
+            void push( Task task ) {
+                if( _failed ) {
+                    return;
+                }
+                auto const &this_thread = current();
+                auto &queue = _queues[this == this_thread._state ? this_thread._slot : 0u];
+                ++_pending;
                 {
-                    kA3DTypeMkpAnnotationEntity,
-                    [](A3DEntity *ntt) {
-                        A3DAsmProductOccurrenceWrapper d( ntt );
-                        return toVector( d->m_ppAnnotations, d->m_uiAnnotationsSize );
+                    std::lock_guard<std::mutex> const lock( queue._mutex );
+                    queue._tasks.push_back( std::move( task ) );
+                }
+                ++_queued;
+                if( 0u != _sleepers ) {
+                    std::lock_guard<std::mutex> const lock( _idle_mutex );
+                    _idle_cv.notify_one();
+                }
+            }
+
+            // Takes the newest task of the thread's own queue, or else
+            // steals the oldest task of another queue
+            bool pop( size_t const slot, Task &task ) {
+                for( auto offset = size_t( 0u ); offset < _queues.size(); ++offset ) {
+                    auto &queue = _queues[(slot + offset) % _queues.size()];
+                    std::lock_guard<std::mutex> const lock( queue._mutex );
+                    if( queue._tasks.empty() ) {
+                        continue;
+                    }
+                    if( 0u == offset ) {
+                        task = std::move( queue._tasks.back() );
+                        queue._tasks.pop_back();
+                    } else {
+                        task = std::move( queue._tasks.front() );
+                        queue._tasks.pop_front();
+                    }
+                    --_queued;
+                    return true;
+                }
+                return false;
+            }
+
+            // Sleeps until a task is queued or all tasks are complete. Pushing
+            // and completing tasks notify while holding _idle_mutex, so a
+            // notification cannot be missed between the checks and the wait.
+            void idle( void ) {
+                std::unique_lock<std::mutex> lock( _idle_mutex );
+                ++_sleepers;
+                if( 0u == _queued && 0u != _pending ) {
+                    _idle_cv.wait( lock );
+                }
+                --_sleepers;
+            }
+
+            // Runs tasks using the queue at slot until none are pending
+            void work( size_t const slot ) {
+                auto &this_thread = current();
+                auto const previous = this_thread;
+                this_thread._state = this;
+                this_thread._slot = slot;
+                while( 0u != _pending ) {
+                    Task task;
+                    if( !pop( slot, task ) ) {
+                        idle();
+                        continue;
+                    }
+                    if( !_failed ) {
+                        try {
+                            task();
+                        } catch( ... ) {
+                            std::lock_guard<std::mutex> const lock( _idle_mutex );
+                            if( !_exception ) {
+                                _exception = std::current_exception();
+                            }
+                            _failed = true;
+                        }
+                    }
+                    task = nullptr;
+                    if( 1u == _pending-- ) {
+                        std::lock_guard<std::mutex> const lock( _idle_mutex );
+                        _idle_cv.notify_all();
+                    }
+                }
+                this_thread = previous;
+            }
+        };
+
+        unsigned int const _thread_count;
+        std::shared_ptr<State> _state;
+    };
+}
+
+namespace {
+    using namespace ts3d;
+    using TypeSet = std::set<A3DEEntityType>;
+    using TypePath = std::vector<A3DEEntityType>;
+    using TypePathArray = std::vector<TypePath>;
+
+    // Function used to append the child objects of a particular
+    // type to the provided array. Writing into a caller supplied
+    // array allows the storage to be reused during traversal.
+    using ChildGetter = void (*)( A3DEntity *, EntityArray & );
+
+    template<typename T, typename S>
+    static inline void append( EntityArray &children, T *d, S const &sz ) {
+        if( nullptr != d ) {
+            children.insert( children.end(), d, d + sz );
+        }
+    }
+
+    static inline void getModelFileProductOccurrences( A3DEntity *ntt, EntityArray &children ) {
+        A3DAsmModelFileWrapper d( ntt );
+        append( children, d->m_ppPOccurrences, d->m_uiPOccurrencesSize );
+    }
+
+    static inline void getProductOccurrenceProductOccurrences( A3DEntity *ntt, EntityArray &children ) {
+        // use the prototype's children if the product occurrence has none of its own
+        while( nullptr != ntt ) {
+            A3DAsmProductOccurrenceWrapper d( ntt );
+            if( 0 != d->m_uiPOccurrencesSize ) {
+                append( children, d->m_ppPOccurrences, d->m_uiPOccurrencesSize );
+                return;
+            }
+            ntt = d->m_pPrototype;
+        }
+    }
+
+    static inline void getProductOccurrencePartDefinition( A3DEntity *ntt, EntityArray &children ) {
+        auto const part_definition = getPartDefinition( ntt, PrototypeOption::Use );
+        if( nullptr != part_definition ) {
+            children.push_back( part_definition );
+        }
+    }
+
+    static inline void getProductOccurrenceViews( A3DEntity *ntt, EntityArray &children ) {
+        A3DAsmProductOccurrenceWrapper d( ntt );
+        append( children, d->m_ppViews, d->m_uiViewsSize );
+    }
+
+    static inline void getProductOccurrenceCameras( A3DEntity *ntt, EntityArray &children ) {
+        A3DAsmProductOccurrenceWrapper d( ntt );
+        append( children, d->m_ppCamera, d->m_uiCameraSize );
+    }
+
+    static inline void getProductOccurrenceAnnotations( A3DEntity *ntt, EntityArray &children ) {
+        A3DAsmProductOccurrenceWrapper d( ntt );
+        append( children, d->m_ppAnnotations, d->m_uiAnnotationsSize );
+    }
+
+    static inline void getPartDefinitionRepresentationItems( A3DEntity *ntt, EntityArray &children ) {
+        A3DAsmPartDefinitionWrapper d( ntt );
+        append( children, d->m_ppRepItems, d->m_uiRepItemsSize );
+    }
+
+    static inline void getPartDefinitionAnnotations( A3DEntity *ntt, EntityArray &children ) {
+        A3DAsmPartDefinitionWrapper d( ntt );
+        append( children, d->m_ppAnnotations, d->m_uiAnnotationsSize );
+    }
+
+    static inline void getPartDefinitionViews( A3DEntity *ntt, EntityArray &children ) {
+        A3DAsmPartDefinitionWrapper d( ntt );
+        append( children, d->m_ppViews, d->m_uiViewsSize );
+    }
+
+    static inline void getRepresentationItemRepresentationItems( A3DEntity *ntt, EntityArray &children ) {
+        if( kA3DTypeRiSet == getEntityType( ntt ) ) {
+            A3DRiSetWrapper d( ntt );
+            append( children, d->m_ppRepItems, d->m_uiRepItemsSize );
+        }
+    }
+
+    static inline void getRepresentationItemBrepData( A3DEntity *ntt, EntityArray &children ) {
+        auto const ntt_type = getEntityType( ntt );
+        if( kA3DTypeRiBrepModel == ntt_type ) {
+            A3DRiBrepModelWrapper d( ntt );
+            children.push_back( d->m_pBrepData );
+        } else if( kA3DTypeRiPlane == ntt_type ) {
+            A3DRiPlaneWrapper d( ntt );
+            children.push_back( d->m_pBrepData );
+        }
+    }
+
+    static inline void getRepresentationItemSingleWireBody( A3DEntity *ntt, EntityArray &children ) {
+        if( kA3DTypeRiCurve == getEntityType( ntt ) ) {
+            A3DRiCurveWrapper d( ntt );
+            children.push_back( d->m_pBody );
+        }
+    }
+
+    static inline void getBrepDataConnexes( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoBrepDataWrapper d( ntt );
+        append( children, d->m_ppConnexes, d->m_uiConnexSize );
+    }
+
+    static inline void getConnexShells( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoConnexWrapper d( ntt );
+        append( children, d->m_ppShells, d->m_uiShellSize );
+    }
+
+    static inline void getShellFaces( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoShellWrapper d( ntt );
+        append( children, d->m_ppFaces, d->m_uiFaceSize );
+    }
+
+    static inline void getFaceLoops( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoFaceWrapper d( ntt );
+        append( children, d->m_ppLoops, d->m_uiLoopSize );
+    }
+
+    static inline void getLoopCoEdges( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoLoopWrapper d( ntt );
+        append( children, d->m_ppCoEdges, d->m_uiCoEdgeSize );
+    }
+
+    static inline void getCoEdgeEdge( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoCoEdgeWrapper d( ntt );
+        children.push_back( d->m_pEdge );
+    }
+
+    static inline void getEdgeVertices( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoEdgeWrapper d( ntt );
+        children.push_back( d->m_pStartVertex );
+        children.push_back( d->m_pEndVertex );
+    }
+
+    static inline void getSingleWireBodyWireEdge( A3DEntity *ntt, EntityArray &children ) {
+        A3DTopoSingleWireBodyWrapper d( ntt );
+        children.push_back( d->m_pWireEdge );
+    }
+
+    static inline void getAnnotationEntityAnnotationEntities( A3DEntity *ntt, EntityArray &children ) {
+        if( kA3DTypeMkpAnnotationSet == getEntityType( ntt ) ) {
+            A3DMkpAnnotationSetWrapper d( ntt );
+            append( children, d->m_ppAnnotations, d->m_uiAnnotationsSize );
+        }
+    }
+
+    static inline void getAnnotationEntityLinkedItems( A3DEntity *ntt, EntityArray &children ) {
+        if( kA3DTypeMkpAnnotationReference == getEntityType( ntt ) ) {
+            A3DMkpAnnotationReferenceWrapper d( ntt );
+            append( children, d->m_ppLinkedItems, d->m_uiLinkedItemsSize );
+        }
+    }
+
+    static inline void getAnnotationEntityMarkup( A3DEntity *ntt, EntityArray &children ) {
+        if( kA3DTypeMkpAnnotationItem == getEntityType( ntt ) ) {
+            A3DMkpAnnotationItemWrapper d( ntt );
+            children.push_back( d->m_pMarkup );
+        }
+    }
+
+    static inline void getMarkupLinkedItems( A3DEntity *ntt, EntityArray &children ) {
+        A3DMkpMarkupWrapper d( ntt );
+        append( children, d->m_ppLinkedItems, d->m_uiLinkedItemsSize );
+    }
+
+    static inline void getMarkupLeaders( A3DEntity *ntt, EntityArray &children ) {
+        A3DMkpMarkupWrapper d( ntt );
+        append( children, d->m_ppLeaders, d->m_uiLeadersSize );
+    }
+
+    // An entry in the decomposition table. It describes how to obtain
+    // the children of type child_type from an owning object whose
+    // (base) type is owner_type.
+    struct Decomposition {
+        A3DEEntityType _owner_type;
+        A3DEEntityType _child_type;
+        ChildGetter _getter;
+    };
+
+    // The decomposition table describes every parent to child
+    // relationship that can be traversed. It is a constant table
+    // of plain function pointers, so fetching children costs a
+    // direct call once the getter has been resolved.
+    static Decomposition const _decompositions[] = {
+        { kA3DTypeAsmModelFile,           kA3DTypeAsmProductOccurrence,  &getModelFileProductOccurrences },
+        { kA3DTypeAsmProductOccurrence,   kA3DTypeAsmProductOccurrence,  &getProductOccurrenceProductOccurrences },
+        { kA3DTypeAsmProductOccurrence,   kA3DTypeAsmPartDefinition,     &getProductOccurrencePartDefinition },
+        { kA3DTypeAsmProductOccurrence,   kA3DTypeMkpView,               &getProductOccurrenceViews },
+        { kA3DTypeAsmProductOccurrence,   kA3DTypeGraphCamera,           &getProductOccurrenceCameras },
+        { kA3DTypeAsmProductOccurrence,   kA3DTypeMkpAnnotationEntity,   &getProductOccurrenceAnnotations },
+        { kA3DTypeAsmPartDefinition,      kA3DTypeRiRepresentationItem,  &getPartDefinitionRepresentationItems },
+        { kA3DTypeAsmPartDefinition,      kA3DTypeMkpAnnotationEntity,   &getPartDefinitionAnnotations },
+        { kA3DTypeAsmPartDefinition,      kA3DTypeMkpView,               &getPartDefinitionViews },
+        { kA3DTypeRiRepresentationItem,   kA3DTypeRiRepresentationItem,  &getRepresentationItemRepresentationItems },
+        { kA3DTypeRiRepresentationItem,   kA3DTypeTopoBrepData,          &getRepresentationItemBrepData },
+        { kA3DTypeRiRepresentationItem,   kA3DTypeTopoSingleWireBody,    &getRepresentationItemSingleWireBody },
+        { kA3DTypeTopoBrepData,           kA3DTypeTopoConnex,            &getBrepDataConnexes },
+        { kA3DTypeTopoConnex,             kA3DTypeTopoShell,             &getConnexShells },
+        { kA3DTypeTopoShell,              kA3DTypeTopoFace,              &getShellFaces },
+        { kA3DTypeTopoFace,               kA3DTypeTopoLoop,              &getFaceLoops },
+        { kA3DTypeTopoLoop,               kA3DTypeTopoCoEdge,            &getLoopCoEdges },
+        { kA3DTypeTopoCoEdge,             kA3DTypeTopoEdge,              &getCoEdgeEdge },
+        { kA3DTypeTopoEdge,               kA3DTypeTopoVertex,            &getEdgeVertices },
+        { kA3DTypeTopoSingleWireBody,     kA3DTypeTopoWireEdge,          &getSingleWireBodyWireEdge },
+        { kA3DTypeMkpAnnotationEntity,    kA3DTypeMkpAnnotationEntity,   &getAnnotationEntityAnnotationEntities },
+        { kA3DTypeMkpAnnotationEntity,    kA3DTypeMiscMarkupLinkedItem,  &getAnnotationEntityLinkedItems },
+        { kA3DTypeMkpAnnotationEntity,    kA3DTypeMkpMarkup,             &getAnnotationEntityMarkup }, // Base type, matches all markups
+        { kA3DTypeMkpMarkup,              kA3DTypeMiscMarkupLinkedItem,  &getMarkupLinkedItems },
+        { kA3DTypeMkpMarkup,              kA3DTypeMkpLeader,             &getMarkupLeaders }
+    };
+
+    // Looks up the getter for the given owner and child base types.
+    // Returns nullptr if no such decomposition exists.
+    static inline ChildGetter getChildGetter( A3DEEntityType const &owner_base_type, A3DEEntityType const &child_base_type ) {
+        for( auto const &decomposition : _decompositions ) {
+            if( decomposition._owner_type == owner_base_type && decomposition._child_type == child_base_type ) {
+                return decomposition._getter;
+            }
+        }
+        return nullptr;
+    }
+
+    // Returns true if objects of the given base type can be decomposed
+    static inline bool hasDecomposition( A3DEEntityType const &owner_base_type ) {
+        for( auto const &decomposition : _decompositions ) {
+            if( decomposition._owner_type == owner_base_type ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Since some entity types "derived", this function is a helper
+    // used to obtain a "base" type for entity_type
+    static inline A3DEEntityType getBaseType( A3DEEntityType const &entity_type ) {
+        auto base_type = entity_type;
+        if( isRepresentationItem( entity_type ) ) {
+            base_type = kA3DTypeRiRepresentationItem;
+        } else if( isTessBase( entity_type ) ) {
+            base_type = kA3DTypeTessBase;
+        } else if( kA3DTypeTopoUniqueVertex == entity_type || kA3DTypeTopoMultipleVertex == entity_type ) {
+            base_type = kA3DTypeTopoVertex;
+        } else if( isAnnotationEntity( entity_type ) ) {
+            base_type = kA3DTypeMkpAnnotationEntity;
+        } else if( isMarkup( entity_type ) ) {
+            base_type = kA3DTypeMkpMarkup;
+        }
+        return base_type;
+    }
+    
+    // The possible parents of, and type paths between, every pair of entity
+    // types present in the decomposition table. The table is computed in
+    // full the first time it is used and never modified afterwards, so it
+    // can be read concurrently from any number of threads. Initialization
+    // of the function local static is itself thread safe.
+    class TypePathTable {
+    public:
+        static TypePathTable const &instance( void ) {
+            static TypePathTable const _instance;
+            return _instance;
+        }
+
+        TypeSet const &possibleParents( A3DEEntityType const &child_type ) const {
+            auto const child_idx = indexOf( child_type );
+            return child_idx < _types.size() ? _possible_parents[child_idx] : _no_types;
+        }
+
+        TypePathArray const &possibleTypePaths( A3DEEntityType const &parent_type, A3DEEntityType const &child_type ) const {
+            auto const parent_idx = indexOf( parent_type );
+            auto const child_idx = indexOf( child_type );
+            if( parent_idx >= _types.size() || child_idx >= _types.size() ) {
+                return _no_type_paths;
+            }
+            return _type_paths[parent_idx * _types.size() + child_idx];
+        }
+
+    private:
+        TypePathTable( void ) {
+            for( auto const &decomposition : _decompositions ) {
+                _types.push_back( decomposition._owner_type );
+                _types.push_back( decomposition._child_type );
+            }
+            std::sort( _types.begin(), _types.end() );
+            _types.erase( std::unique( _types.begin(), _types.end() ), _types.end() );
+
+            _possible_parents.resize( _types.size() );
+            for( auto const &decomposition : _decompositions ) {
+                _possible_parents[indexOf( decomposition._child_type )].insert( decomposition._owner_type );
+            }
+
+            _type_paths.resize( _types.size() * _types.size() );
+            std::vector<bool> computed( _type_paths.size(), false );
+            for( auto parent_idx = 0u; parent_idx < _types.size(); ++parent_idx ) {
+                for( auto child_idx = 0u; child_idx < _types.size(); ++child_idx ) {
+                    computeTypePaths( parent_idx, child_idx, computed );
+                }
+            }
+        }
+
+        size_t indexOf( A3DEEntityType const &type ) const {
+            auto const it = std::lower_bound( _types.begin(), _types.end(), type );
+            return it != _types.end() && *it == type ? static_cast<size_t>( it - _types.begin() ) : _types.size();
+        }
+
+        // Each type path returned is one possible way to traverse the Exchange
+        // data structures such that the beginning entity type and ending entity
+        // type are equal to the input parameters.
+        void computeTypePaths( size_t const parent_idx, size_t const child_idx, std::vector<bool> &computed ) {
+            auto const idx = parent_idx * _types.size() + child_idx;
+            if( computed[idx] ) {
+                return;
+            }
+            computed[idx] = true;
+
+            auto const parent_type = _types[parent_idx];
+            auto const child_type = _types[child_idx];
+            auto const &possible_parents = _possible_parents[child_idx];
+            if( std::end( possible_parents ) != possible_parents.find( parent_type ) ) {
+                // child entity type is an immediate child of parent entity type
+                _type_paths[idx].push_back( TypePath( { parent_type, child_type } ) );
+                return;
+            }
+
+            // child entity type is not an immediate child of parent entity type
+            // so we must iterate over the list of all possible parent types
+            // and for each of those parent types, examine up the ownership chain
+            for( auto const intermediate_parent_type : possible_parents ) {
+                if( intermediate_parent_type != child_type ) {
+                    auto const intermediate_idx = indexOf( intermediate_parent_type );
+                    computeTypePaths( parent_idx, intermediate_idx, computed );
+                    for( auto const &intermediate_type_path : _type_paths[parent_idx * _types.size() + intermediate_idx] ) {
+                        _type_paths[idx].push_back( intermediate_type_path );
+                        _type_paths[idx].back().push_back( child_type );
+                    }
+                }
+            }
+        }
+
+        std::vector<A3DEEntityType> _types;
+        std::vector<TypeSet> _possible_parents;
+        std::vector<TypePathArray> _type_paths;
+        TypeSet const _no_types;
+        TypePathArray const _no_type_paths;
+    };
+
+    // For an entity type child_type, this function returns
+    // a list of entity types that can contain the child type
+    static inline TypeSet const &getPossibleParents( A3DEEntityType const &child_type ) {
+        return TypePathTable::instance().possibleParents( child_type );
+    }
+
+    // This function can be used to obtain a set of type paths where the parent type
+    // and leaf child type values are both given. Each type path returned is one
+    // possible way to traverse the Exchange data structures such that the beginning
+    // entity type and ending entity type are equal to the input parameters.
+    static inline TypePathArray const &getPossibleTypePaths( A3DEEntityType const &parent_type, A3DEEntityType const &child_type ) {
+        return TypePathTable::instance().possibleTypePaths( parent_type, child_type );
+    }
+    
+    // Determines if ntt satisfies a requested leaf type. A base type
+    // such as kA3DTypeRiRepresentationItem matches all derived types.
+    static inline bool isLeafOfType( A3DEntity *ntt, A3DEEntityType const &leaf_type ) {
+        return leaf_type == getBaseType( leaf_type ) || getEntityType( ntt ) == leaf_type;
+    }
+
+    // Invokes fn( idx ) for each idx in [0, count) using up to thread_count
+    // threads of the WorkerPool, including the calling thread. Each thread owns
+    // a contiguous block of indexes which it consumes from the front. Once its
+    // own block is exhausted, a thread steals from the back of the other blocks.
+    // The first exception thrown by fn is rethrown on the calling thread.
+    static inline void parallelFor( size_t const count, unsigned int thread_count, std::function<void( size_t )> const &fn ) {
+        if( 0u == thread_count ) {
+            thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+        }
+        thread_count = static_cast<unsigned int>( std::min<size_t>( thread_count, count ) );
+        if( thread_count < 2u ) {
+            for( auto idx = size_t( 0u ); idx < count; ++idx ) {
+                fn( idx );
+            }
+            return;
+        }
+
+        struct WorkQueue {
+            std::mutex _mutex;
+            size_t _begin = 0u;
+            size_t _end = 0u;
+        };
+        std::vector<WorkQueue> queues( thread_count );
+        auto const block_size = count / thread_count;
+        auto const remainder = count % thread_count;
+        auto next_begin = size_t( 0u );
+        for( auto q = 0u; q < thread_count; ++q ) {
+            queues[q]._begin = next_begin;
+            next_begin += block_size + (q < remainder ? 1u : 0u);
+            queues[q]._end = next_begin;
+        }
+
+        std::atomic<bool> failed( false );
+        auto const worker = [&]( unsigned int const q ) {
+            while( !failed ) {
+                auto found = false;
+                auto idx = size_t( 0u );
+                for( auto offset = 0u; offset < thread_count && !found; ++offset ) {
+                    auto &queue = queues[(q + offset) % thread_count];
+                    std::lock_guard<std::mutex> const lock( queue._mutex );
+                    if( queue._begin < queue._end ) {
+                        idx = 0u == offset ? queue._begin++ : --queue._end;
+                        found = true;
+                    }
+                }
+                if( !found ) {
+                    return;
+                }
+                try {
+                    fn( idx );
+                } catch( ... ) {
+                    failed = true;
+                    throw;
+                }
+            }
+        };
+
+        TaskGroup group( thread_count );
+        for( auto q = 0u; q < thread_count; ++q ) {
+            group.spawn( [&worker, q]() {
+                worker( q );
+            });
+        }
+        group.wait();
+    }
+}
+
+namespace ts3d {
+    /*! \private
+     * \brief The possible type paths from an owner type to each of a set of leaf
+     * types, merged into a tree so that common prefixes are shared. Each
+     * node records the leaf types whose type paths end there.
+     */
+    struct TypeTree {
+        struct Leaf {
+            size_t _leaf_type_idx;
+            size_t _type_path_idx;
+        };
+
+        // The getter obtains entities of this node's type
+        // from an entity of the parent node's type
+        struct Node {
+            A3DEEntityType _type;
+            bool _has_decomposition;
+            ChildGetter _getter;
+            std::vector<size_t> _branches;
+            std::vector<Leaf> _leaves;
+        };
+
+        TypeTree( void ) {
+        }
+
+        // Duplicate leaf types are ignored
+        TypeTree( A3DEEntityType const &owner_base_type, EntityTypeArray const &leaf_types ) {
+            _nodes.push_back( { owner_base_type, hasDecomposition( owner_base_type ), nullptr, {}, {} } );
+            for( auto leaf_type_idx = 0u; leaf_type_idx < leaf_types.size(); ++leaf_type_idx ) {
+                auto const leaf_type = leaf_types[leaf_type_idx];
+                if( std::find( leaf_types.begin(), leaf_types.begin() + leaf_type_idx, leaf_type ) != leaf_types.begin() + leaf_type_idx ) {
+                    continue;
+                }
+                auto const &type_paths = getPossibleTypePaths( owner_base_type, getBaseType( leaf_type ) );
+                for( auto type_path_idx = 0u; type_path_idx < type_paths.size(); ++type_path_idx ) {
+                    auto const &type_path = type_paths[type_path_idx];
+                    if( type_path.empty() ) {
+                        continue;
+                    }
+                    auto node_idx = size_t( 0u );
+                    for( auto type_idx = 1u; type_idx < type_path.size(); ++type_idx ) {
+                        auto const &branches = _nodes[node_idx]._branches;
+                        auto const branch_it = std::find_if( branches.begin(), branches.end(), [this, &type_path, type_idx]( size_t const branch ) {
+                            return _nodes[branch]._type == type_path[type_idx];
+                        });
+                        if( branch_it != branches.end() ) {
+                            node_idx = *branch_it;
+                            continue;
+                        }
+                        _nodes.push_back( { type_path[type_idx], hasDecomposition( type_path[type_idx] ), getChildGetter( type_path[type_idx - 1u], type_path[type_idx] ), {}, {} } );
+                        _nodes[node_idx]._branches.push_back( _nodes.size() - 1u );
+                        node_idx = _nodes.size() - 1u;
                     }
+                    _nodes[node_idx]._leaves.push_back( { leaf_type_idx, type_path_idx } );
+                }
+            }
+        }
+
+        // The tree of a single type path, whose leaves record type_path_idx
+        TypeTree( TypePath const &type_path, size_t const type_path_idx ) {
+            if( type_path.empty() ) {
+                return;
+            }
+            _nodes.push_back( { type_path.front(), hasDecomposition( type_path.front() ), nullptr, {}, {} } );
+            for( auto type_idx = 1u; type_idx < type_path.size(); ++type_idx ) {
+                _nodes.push_back( { type_path[type_idx], hasDecomposition( type_path[type_idx] ), getChildGetter( type_path[type_idx - 1u], type_path[type_idx] ), {}, {} } );
+                _nodes[type_idx - 1u]._branches.push_back( type_idx );
+            }
+            _nodes.back()._leaves.push_back( { 0u, type_path_idx } );
+        }
+
+        std::vector<Node> _nodes;
+    };
+
+    /*! \brief Stores the children of entities read during traversal so that
+     * each entity is decomposed at most once.
+     *
+     * Traversal functions that accept a TraversalCache consult it before reading
+     * child entities from Exchange. The first time the children of a particular
+     * type are needed for an entity, they are read and appended to a single
+     * contiguous array. Later requests for the same entity and child type are
+     * satisfied from that array. For assemblies that instance the same part many
+     * times, the part is decomposed once rather than once per instance.
+     * \code
+     * ts3d::TraversalCache cache;
+     * auto const ri_paths = ts3d::getLeafInstances( model_file, kA3DTypeRiRepresentationItem, cache );
+     * auto const face_paths = ts3d::getLeafInstances( model_file, kA3DTypeTopoFace, cache );
+     * \endcode
+     * The cache holds entity pointers and is never invalidated automatically.
+     * Clear or discard it if the model is modified or freed. A cache must not be
+     * used by more than one thread at a time.
+     * \ingroup traversal
+     */
+    class TraversalCache {
+    public:
+        /*! \brief The number of child arrays stored.
+         */
+        size_t size( void ) const {
+            return _ranges.size();
+        }
+
+        /*! \brief Removes all stored child arrays.
+         */
+        void clear( void ) {
+            _ranges.clear();
+            _children.clear();
+        }
+
+        /*! \private
+         * \brief Appends the children of \c owner of type \c child_base_type to \c children.
+         * \c getter is only invoked if they have not been stored previously.
+         */
+        void append( A3DEntity *owner, A3DEEntityType const &child_base_type, ChildGetter const getter, EntityArray &children ) {
+            auto const key = Key( owner, child_base_type );
+            auto it = _ranges.find( key );
+            if( std::end( _ranges ) == it ) {
+                auto const begin = _children.size();
+                if( nullptr != getter ) {
+                    getter( owner, _children );
                 }
+                it = _ranges.emplace( key, Range( begin, _children.size() ) ).first;
+            }
+            children.insert( children.end(), _children.begin() + it->second.first, _children.begin() + it->second.second );
+        }
+
+    private:
+        using Key = std::pair<A3DEntity*, A3DEEntityType>;
+        using Range = std::pair<size_t, size_t>;
+
+        struct KeyHash {
+            size_t operator()( Key const &key ) const noexcept {
+                return std::hash<A3DEntity*>()( key.first ) ^ (static_cast<size_t>( key.second ) << 1);
+            }
+        };
+
+        std::unordered_map<Key, Range, KeyHash> _ranges;
+        EntityArray _children;
+    };
+
+    /*! \brief An input iterator that lazily walks the Exchange data model looking
+     * for leaf entities of several types at once.
+     *
+     * The possible type paths from the owner to each of the leaf types are merged
+     * into a single tree of types, which is walked depth first. Each entity is
+     * read once, no matter how many of the leaf types lie below it. Paths are
+     * produced in depth first order, so paths to different leaf types are
+     * interleaved. Use leafType() to determine which of the requested types
+     * the current path was found for.
+     *
+     * The referenced InstancePath is only valid until the iterator is advanced.
+     * Copy it if it must outlive the iteration step.
+     * \sa leafInstances( A3DEntity *, EntityTypeArray const & )
+     * \ingroup traversal
+     */
+    class MultiLeafInstanceIterator {
+    public:
+        /*! \private */
+        using iterator_category = std::input_iterator_tag;
+        /*! \private */
+        using value_type = InstancePath;
+        /*! \private */
+        using difference_type = std::ptrdiff_t;
+        /*! \private */
+        using pointer = InstancePath const *;
+        /*! \private */
+        using reference = InstancePath const &;
+
+        /*! \brief Constructs an iterator that is past the end.
+         */
+        MultiLeafInstanceIterator( void ) {
+        }
+
+        /*! \brief Constructs an iterator positioned at the first instance path
+         * from \c owner to an entity of any of the types in \c leaf_types.
+         * \param owner The top level object to begin traversal.
+         * \param leaf_types The types of child nodes to look for. Duplicates are ignored.
+         * \param node_cb Optional callback invoked once as each node is reached. It can
+         * be used to prune subtrees or to stop the traversal. \sa visitLeafInstances
+         * \param cache Optional cache used to obtain the children of each entity. \sa TraversalCache
+         */
+        MultiLeafInstanceIterator( A3DEntity *owner, EntityTypeArray const &leaf_types, TraversalCallback const &node_cb = TraversalCallback(), TraversalCache *cache = nullptr )
+        : _owner( owner ), _leaf_types( leaf_types ), _node_cb( node_cb ), _cache( cache ), _done( false ) {
+            _tree = std::make_shared<TypeTree const>( getBaseType( getEntityType( owner ) ), _leaf_types );
+            advance();
+        }
+
+        /*! \private
+         * \brief Constructs an iterator that traverses below \c ntt only, which is
+         * reached by appending it to \c base_path and corresponds to \c node of \c tree.
+         * If \c split_at_product_occurrences is \c true, the iterator does not descend
+         * into product occurrences found below \c ntt. Instead, each of them is reported
+         * and isSubtree() returns \c true. Used for parallel traversal, and to
+         * traverse one type path at a time.
+         */
+        MultiLeafInstanceIterator( std::shared_ptr<TypeTree const> const &tree, EntityTypeArray const &leaf_types, InstancePath const &base_path, A3DEntity *ntt, size_t const node, bool const split_at_product_occurrences, TraversalCallback const &node_cb = TraversalCallback(), TraversalCache *cache = nullptr )
+        : _owner( ntt ), _leaf_types( leaf_types ), _node_cb( node_cb ), _cache( cache ), _tree( tree ), _path( base_path ), _root_node( node ), _split( split_at_product_occurrences ), _done( false ) {
+            advance();
+        }
+
+        /*! \private
+         * \brief Indicates the current path is a product occurrence subtree
+         * that has not been traversed.
+         */
+        bool isSubtree( void ) const {
+            return _at_subtree;
+        }
+
+        /*! \private
+         * \brief The type tree node of the product occurrence reported by isSubtree().
+         */
+        size_t subtreeNode( void ) const {
+            return _subtree_node;
+        }
+
+        /*! \private
+         * \brief Indicates the traversal was terminated by the node callback.
+         */
+        bool stopped( void ) const {
+            return _stopped;
+        }
+
+        /*! \brief The leaf type the current instance path was found for.
+         */
+        A3DEEntityType leafType( void ) const {
+            return _leaf_types[_leaf._leaf_type_idx];
+        }
+
+        /*! \private
+         * \brief Index into the requested leaf types of leafType().
+         */
+        size_t leafTypeIndex( void ) const {
+            return _leaf._leaf_type_idx;
+        }
+
+        /*! \private
+         * \brief Index of the type path the current instance path follows, among
+         * the possible type paths from the owner to leafType().
+         */
+        size_t typePathIndex( void ) const {
+            return _leaf._type_path_idx;
+        }
+
+        /*! \brief Gets the current instance path.
+         */
+        reference operator*( void ) const {
+            return _path;
+        }
+
+        /*! \brief Gets the current instance path.
+         */
+        pointer operator->( void ) const {
+            return &_path;
+        }
+
+        /*! \brief Advances to the next instance path.
+         */
+        MultiLeafInstanceIterator &operator++( void ) {
+            advance();
+            return *this;
+        }
+
+        /*! \brief Two iterators are equal if both are past the end, or if
+         * both reference the same position of the same traversal.
+         */
+        bool operator==( MultiLeafInstanceIterator const &other ) const {
+            if( _done || other._done ) {
+                return _done == other._done;
             }
-        },
-        {
-            kA3DTypeAsmPartDefinition,
-            {
-                {
-                    kA3DTypeRiRepresentationItem,
-                    [](A3DEntity *ntt) {
-                        A3DAsmPartDefinitionWrapper d( ntt );
-                        return toVector( d->m_ppRepItems, d->m_uiRepItemsSize );
-                    }
-                },
-                {
-                    kA3DTypeMkpAnnotationEntity,
-                    [](A3DEntity *ntt) {
-                        A3DAsmPartDefinitionWrapper d( ntt );
-                        return toVector( d->m_ppAnnotations, d->m_uiAnnotationsSize );
-                    }
-                },
-                {
-                    kA3DTypeMkpView,
-                    []( A3DEntity *ntt) {
-                        A3DAsmPartDefinitionWrapper d( ntt );
-                        return toVector( d->m_ppViews, d->m_uiViewsSize );
-                    }
-                }
+            return _owner == other._owner && _leaf._leaf_type_idx == other._leaf._leaf_type_idx && _at_subtree == other._at_subtree && _path == other._path;
+        }
+
+        /*! \brief Negation of operator==
+         */
+        bool operator!=( MultiLeafInstanceIterator const &other ) const {
+            return !(*this == other);
+        }
+
+    private:
+        enum class Stage {
+            // the entity has just been pushed and must be examined
+            Enter,
+            // iterating nested children of the same type (sub-occurrences, set members)
+            Nested,
+            // reporting the entity for each leaf type whose type path ends here
+            Leaves,
+            // fetching the children for the next branch of the type tree
+            Descend,
+            // iterating the children of the current branch
+            Children,
+            // all branches are exhausted, the entity is popped
+            Done
+        };
+
+        struct Frame {
+            A3DEntity *_ntt = nullptr;
+            A3DEEntityType _base_type = kA3DTypeUnknown;
+            size_t _node = 0u;
+            Stage _stage = Stage::Enter;
+            EntityArray _children;
+            size_t _next_child = 0u;
+            size_t _branch = 0u;
+            size_t _next_leaf = 0u;
+            bool _skip_descend = false;
+        };
+
+        void push( A3DEntity *ntt, size_t const node ) {
+            if( _depth == _frames.size() ) {
+                _frames.emplace_back();
             }
-        },
-        {
-            kA3DTypeRiRepresentationItem,
-            {
-                {
-                    kA3DTypeRiRepresentationItem,
-                    [](A3DEntity *ntt) {
-                        if( kA3DTypeRiSet == getEntityType( ntt ) ) {
-                            A3DRiSetWrapper d( ntt );
-                            return toVector( d->m_ppRepItems, d->m_uiRepItemsSize );
-                        }
-                        return EntityArray();
-                    }
-                },
-                {
-                    kA3DTypeTopoBrepData,
-                    [](A3DEntity *ntt) {
-                        auto const ntt_type = getEntityType( ntt );
-                        if( kA3DTypeRiBrepModel == ntt_type ) {
-                            A3DRiBrepModelWrapper d( ntt );
-                            return EntityArray( 1, d->m_pBrepData );
-                        } else if( kA3DTypeRiPlane == ntt_type ) {
-                            A3DRiPlaneWrapper d( ntt );
-                            return EntityArray( 1, d->m_pBrepData );
-                        }
-                        return EntityArray();
-                    }
-                },
-                {
-                    kA3DTypeTopoSingleWireBody,
-                    [](A3DEntity *ntt) {
-                        if( kA3DTypeRiCurve == getEntityType( ntt ) ) {
-                            A3DRiCurveWrapper d( ntt );
-                            return EntityArray( 1, d->m_pBody );
-                        }
-                        return EntityArray();
-                    }
-                }
+            auto &frame = _frames[_depth++];
+            frame._ntt = ntt;
+            frame._base_type = kA3DTypeUnknown;
+            frame._node = node;
+            frame._stage = Stage::Enter;
+            frame._children.clear();
+            frame._next_child = 0u;
+            frame._branch = 0u;
+            frame._next_leaf = 0u;
+            frame._skip_descend = false;
+            _path.push_back( ntt );
+        }
+
+        void pop( void ) {
+            --_depth;
+            _path.pop_back();
+        }
+
+        // Pushes ntt, or reports it as a subtree if the traversal is split at
+        // product occurrences. Returns true if ntt was reported.
+        bool enter( A3DEntity *ntt, size_t const node ) {
+            if( _split && kA3DTypeAsmProductOccurrence == _tree->_nodes[node]._type ) {
+                _path.push_back( ntt );
+                _subtree_node = node;
+                _at_subtree = true;
+                return true;
             }
-        },
-        {
-            kA3DTypeTopoBrepData,
-            {
-                {
-                    kA3DTypeTopoConnex,
-                    [](A3DEntity *ntt) {
-                        A3DTopoBrepDataWrapper d( ntt );
-                        return toVector( d->m_ppConnexes, d->m_uiConnexSize );
-                    }
-                }
+            push( ntt, node );
+            return false;
+        }
+
+        void finish( void ) {
+            _done = true;
+            _depth = 0u;
+            _path.clear();
+        }
+
+        void fetch( A3DEntity *ntt, A3DEEntityType const &child_base_type, ChildGetter const getter, EntityArray &children ) {
+            if( nullptr != _cache ) {
+                _cache->append( ntt, child_base_type, getter, children );
+            } else if( nullptr != getter ) {
+                getter( ntt, children );
             }
-        },
-        {
-            kA3DTypeTopoConnex,
-            {
-                {
-                    kA3DTypeTopoShell,
-                    [](A3DEntity *ntt) {
-                        A3DTopoConnexWrapper d( ntt );
-                        return toVector( d->m_ppShells, d->m_uiShellSize );
-                    }
-                }
+        }
+
+        bool isLeaf( A3DEntity *ntt, TypeTree::Leaf const &leaf ) const {
+            return isLeafOfType( ntt, _leaf_types[leaf._leaf_type_idx] );
+        }
+
+        void advance( void ) {
+            if( _at_subtree ) {
+                _at_subtree = false;
+                _path.pop_back();
             }
-        },
-        {
-            kA3DTypeTopoShell,
-            {
-                {
-                    kA3DTypeTopoFace,
-                    [](A3DEntity *ntt) {
-                        A3DTopoShellWrapper d( ntt );
-                        return toVector( d->m_ppFaces, d->m_uiFaceSize );
+            while( !_done ) {
+                if( 0u == _depth ) {
+                    if( _started || _tree->_nodes.empty() || _tree->_nodes.front()._branches.empty() ) {
+                        finish();
+                        return;
                     }
+                    _started = true;
+                    push( _owner, _root_node );
                 }
-            }
-        },
-        {
-            kA3DTypeTopoFace,
-            {
-                {
-                    kA3DTypeTopoLoop,
-                    [](A3DEntity *ntt) {
-                        A3DTopoFaceWrapper d( ntt );
-                        return toVector( d->m_ppLoops, d->m_uiLoopSize );
+
+                auto &frame = _frames[_depth - 1];
+                auto const &node = _tree->_nodes[frame._node];
+                switch( frame._stage ) {
+                    case Stage::Enter: {
+                        if( _node_cb ) {
+                            auto const action = _node_cb( _path );
+                            if( TraversalAction::Stop == action ) {
+                                _stopped = true;
+                                finish();
+                                return;
+                            }
+                            if( TraversalAction::SkipSubtree == action ) {
+                                frame._stage = Stage::Done;
+                                break;
+                            }
+                        }
+                        auto const ntt_type = getEntityType( frame._ntt );
+                        frame._base_type = getBaseType( ntt_type );
+                        auto const on_type_path = frame._base_type == node._type;
+                        if( !(on_type_path ? node._has_decomposition : hasDecomposition( frame._base_type )) ) {
+                            // nothing below this entity, it can only be a leaf
+                            frame._stage = on_type_path ? Stage::Leaves : Stage::Done;
+                            frame._branch = node._branches.size();
+                        } else if( kA3DTypeAsmProductOccurrence == frame._base_type ) {
+                            fetch( frame._ntt, kA3DTypeAsmProductOccurrence, &getProductOccurrenceProductOccurrences, frame._children );
+                            frame._stage = Stage::Nested;
+                        } else if( kA3DTypeRiSet == ntt_type ) {
+                            fetch( frame._ntt, kA3DTypeRiRepresentationItem, &getRepresentationItemRepresentationItems, frame._children );
+                            frame._skip_descend = !frame._children.empty();
+                            frame._stage = Stage::Nested;
+                        } else if( kA3DTypeMkpAnnotationSet == ntt_type ) {
+                            fetch( frame._ntt, kA3DTypeMkpAnnotationEntity, &getAnnotationEntityAnnotationEntities, frame._children );
+                            frame._stage = Stage::Nested;
+                        } else {
+                            frame._stage = Stage::Leaves;
+                        }
+                        break;
                     }
+                    case Stage::Nested:
+                        if( frame._next_child < frame._children.size() ) {
+                            auto const child = frame._children[frame._next_child++];
+                            if( enter( child, frame._node ) ) {
+                                return;
+                            }
+                        } else {
+                            frame._stage = frame._skip_descend ? Stage::Done : Stage::Leaves;
+                        }
+                        break;
+                    case Stage::Leaves:
+                        if( frame._next_leaf < node._leaves.size() ) {
+                            auto const &leaf = node._leaves[frame._next_leaf++];
+                            if( isLeaf( frame._ntt, leaf ) ) {
+                                _leaf = leaf;
+                                TS3D_INSTRUMENT( Instrumentation::recordPath( _path.size() ) );
+                                return;
+                            }
+                        } else {
+                            frame._stage = Stage::Descend;
+                        }
+                        break;
+                    case Stage::Descend:
+                        if( frame._branch < node._branches.size() ) {
+                            auto const &branch = _tree->_nodes[node._branches[frame._branch]];
+                            auto const getter = frame._base_type == node._type ? branch._getter : getChildGetter( frame._base_type, branch._type );
+                            frame._children.clear();
+                            fetch( frame._ntt, branch._type, getter, frame._children );
+                            frame._next_child = 0u;
+                            frame._stage = Stage::Children;
+                        } else {
+                            frame._stage = Stage::Done;
+                        }
+                        break;
+                    case Stage::Children:
+                        if( frame._next_child < frame._children.size() ) {
+                            auto const child = frame._children[frame._next_child++];
+                            if( enter( child, node._branches[frame._branch] ) ) {
+                                return;
+                            }
+                        } else {
+                            ++frame._branch;
+                            frame._stage = Stage::Descend;
+                        }
+                        break;
+                    case Stage::Done:
+                        pop();
+                        break;
                 }
             }
-        },
-        {
-            kA3DTypeTopoLoop,
-            {
-                {
-                    kA3DTypeTopoCoEdge,
-                    [](A3DEntity *ntt) {
-                        A3DTopoLoopWrapper d( ntt );
-                        return toVector( d->m_ppCoEdges, d->m_uiCoEdgeSize );
-                    }
-                }
+        }
+
+        A3DEntity *_owner = nullptr;
+        EntityTypeArray _leaf_types;
+        TraversalCallback _node_cb;
+        TraversalCache *_cache = nullptr;
+        std::shared_ptr<TypeTree const> _tree;
+        std::vector<Frame> _frames;
+        size_t _depth = 0u;
+        InstancePath _path;
+        TypeTree::Leaf _leaf = { 0u, 0u };
+        size_t _root_node = 0u;
+        bool _split = false;
+        bool _at_subtree = false;
+        size_t _subtree_node = 0u;
+        bool _started = false;
+        bool _stopped = false;
+        bool _done = true;
+    };
+
+    /*! \brief A lightweight range over the instance paths from an owner to
+     * all leaf entities of several types. Suitable for use with
+     * range-based \c for loops. \sa leafInstances( A3DEntity *, EntityTypeArray const & )
+     * \ingroup traversal
+     */
+    class MultiLeafInstanceRange {
+    public:
+        /*! \brief Constructs the range. No traversal is performed until begin() is called.
+         */
+        MultiLeafInstanceRange( A3DEntity *owner, EntityTypeArray const &leaf_types, TraversalCallback const &node_cb = TraversalCallback(), TraversalCache *cache = nullptr )
+        : _owner( owner ), _leaf_types( leaf_types ), _node_cb( node_cb ), _cache( cache ) {
+        }
+
+        /*! \brief Begins a new traversal.
+         */
+        MultiLeafInstanceIterator begin( void ) const {
+            return MultiLeafInstanceIterator( _owner, _leaf_types, _node_cb, _cache );
+        }
+
+        /*! \brief The past the end iterator.
+         */
+        MultiLeafInstanceIterator end( void ) const {
+            return MultiLeafInstanceIterator();
+        }
+
+    private:
+        A3DEntity *_owner;
+        EntityTypeArray _leaf_types;
+        TraversalCallback _node_cb;
+        TraversalCache *_cache;
+    };
+
+    /*! \brief Lazily enumerates the instance paths from \c owner to all leaf
+     * entities of any of the types in \c leaf_types using a single traversal.
+     *
+     * Paths to different leaf types are interleaved in depth first order. The
+     * iterator's \c leafType() indicates which type each path was found for.
+     * \code
+     * auto const range = ts3d::leafInstances( model_file, { kA3DTypeRiRepresentationItem, kA3DTypeMkpView } );
+     * for( auto it = range.begin(); it != range.end(); ++it ) {
+     *     if( kA3DTypeMkpView == it.leafType() ) {
+     *         processView( *it );
+     *     } else {
+     *         processRepresentationItem( *it );
+     *     }
+     * }
+     * \endcode
+     * \param owner The top level object to begin traversal.
+     * \param leaf_types The types of child nodes to look for.
+     * \ingroup traversal
+     */
+    static inline MultiLeafInstanceRange leafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types ) {
+        return MultiLeafInstanceRange( owner, leaf_types );
+    }
+
+    /*! \brief Lazily enumerates the instance paths from \c owner to all leaf
+     * entities of any of the types in \c leaf_types, pruning the traversal using \c node_cb.
+     * Unlike the single leaf type variant, \c node_cb is invoked at most once per node.
+     * \sa visitLeafInstances
+     * \ingroup traversal
+     */
+    static inline MultiLeafInstanceRange leafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types, TraversalCallback const &node_cb ) {
+        return MultiLeafInstanceRange( owner, leaf_types, node_cb );
+    }
+
+    /*! \brief Lazily enumerates the instance paths from \c owner to all leaf
+     * entities of any of the types in \c leaf_types, obtaining the children of
+     * each entity from \c cache. \sa TraversalCache
+     * \ingroup traversal
+     */
+    static inline MultiLeafInstanceRange leafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types, TraversalCache &cache ) {
+        return MultiLeafInstanceRange( owner, leaf_types, TraversalCallback(), &cache );
+    }
+
+    /*! \brief An input iterator that lazily walks the Exchange data model and
+     * yields one InstancePath at a time.
+     *
+     * The traversal is performed depth first by a MultiLeafInstanceIterator
+     * looking for \c leaf_type alone, once for each of the possible type paths
+     * from the owner to \c leaf_type. The memory consumed is proportional to the
+     * depth of the hierarchy rather than the number of results. The order in
+     * which paths are produced is identical to the order of the array returned
+     * by getLeafInstances().
+     *
+     * The referenced InstancePath is only valid until the iterator is advanced.
+     * Copy it if it must outlive the iteration step.
+     * \sa leafInstances
+     * \ingroup traversal
+     */
+    class LeafInstanceIterator {
+    public:
+        /*! \private */
+        using iterator_category = std::input_iterator_tag;
+        /*! \private */
+        using value_type = InstancePath;
+        /*! \private */
+        using difference_type = std::ptrdiff_t;
+        /*! \private */
+        using pointer = InstancePath const *;
+        /*! \private */
+        using reference = InstancePath const &;
+
+        /*! \brief Constructs an iterator that is past the end.
+         */
+        LeafInstanceIterator( void ) {
+        }
+
+        /*! \brief Constructs an iterator positioned at the first instance path
+         * from \c owner to an entity of type \c leaf_type.
+         * \param owner The top level object to begin traversal.
+         * \param leaf_type The type of child node to look for.
+         * \param node_cb Optional callback invoked as each node is reached. It can
+         * be used to prune subtrees or to stop the traversal. A node that lies on
+         * more than one type path is reached once for each of them. \sa visitLeafInstances
+         * \param cache Optional cache used to obtain the children of each entity. \sa TraversalCache
+         */
+        LeafInstanceIterator( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCallback const &node_cb = TraversalCallback(), TraversalCache *cache = nullptr )
+        : _owner( owner ), _leaf_types( 1, leaf_type ), _node_cb( node_cb ), _cache( cache ) {
+            _type_paths = &getPossibleTypePaths( getBaseType( getEntityType( owner ) ), getBaseType( leaf_type ) );
+            start();
+        }
+
+        /*! \private
+         * \brief Index of the type path currently being traversed.
+         */
+        size_t typePathIndex( void ) const {
+            return _type_path_idx;
+        }
+
+        /*! \brief Gets the current instance path.
+         */
+        reference operator*( void ) const {
+            return *_it;
+        }
+
+        /*! \brief Gets the current instance path.
+         */
+        pointer operator->( void ) const {
+            return _it.operator->();
+        }
+
+        /*! \brief Advances to the next instance path.
+         */
+        LeafInstanceIterator &operator++( void ) {
+            ++_it;
+            if( MultiLeafInstanceIterator() == _it && !_it.stopped() ) {
+                ++_type_path_idx;
+                start();
             }
-        },
-        {
-            kA3DTypeTopoCoEdge,
-            {
-                {
-                    kA3DTypeTopoEdge,
-                    []( A3DEntity *ntt ) {
-                        A3DTopoCoEdgeWrapper d( ntt );
-                        return EntityArray( 1, d->m_pEdge );
-                        
-                    }
+            return *this;
+        }
+
+        /*! \brief Two iterators are equal if both are past the end, or if
+         * both reference the same position of the same traversal.
+         */
+        bool operator==( LeafInstanceIterator const &other ) const {
+            return _it == other._it && (MultiLeafInstanceIterator() == _it || _type_path_idx == other._type_path_idx);
+        }
+
+        /*! \brief Negation of operator==
+         */
+        bool operator!=( LeafInstanceIterator const &other ) const {
+            return !(*this == other);
+        }
+
+    private:
+        // Begins traversal of the current type path, moving on to the next
+        // one until an instance path is found
+        void start( void ) {
+            for( ; _type_path_idx < _type_paths->size(); ++_type_path_idx ) {
+                auto const tree = std::make_shared<TypeTree const>( (*_type_paths)[_type_path_idx], _type_path_idx );
+                _it = MultiLeafInstanceIterator( tree, _leaf_types, InstancePath(), _owner, 0u, false, _node_cb, _cache );
+                if( MultiLeafInstanceIterator() != _it || _it.stopped() ) {
+                    return;
                 }
             }
-        },
-        {
-            kA3DTypeTopoEdge,
-            {
-                {
-                    kA3DTypeTopoVertex,
-                    []( A3DEntity *ntt ) {
-                        A3DTopoEdgeWrapper d( ntt );
-                        EntityArray result;
-                        result.reserve( 2 );
-                        result.push_back( d->m_pStartVertex );
-                        result.push_back( d->m_pEndVertex );
-                        return result;
-                    }
-                }
+        }
+
+        A3DEntity *_owner = nullptr;
+        EntityTypeArray _leaf_types;
+        TraversalCallback _node_cb;
+        TraversalCache *_cache = nullptr;
+        TypePathArray const *_type_paths = nullptr;
+        size_t _type_path_idx = 0u;
+        MultiLeafInstanceIterator _it;
+    };
+
+    /*! \brief A lightweight range over the instance paths from an owner to
+     * all leaf entities of a particular type. Suitable for use with
+     * range-based \c for loops. \sa leafInstances
+     * \ingroup traversal
+     */
+    class LeafInstanceRange {
+    public:
+        /*! \brief Constructs the range. No traversal is performed until begin() is called.
+         */
+        LeafInstanceRange( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCallback const &node_cb = TraversalCallback(), TraversalCache *cache = nullptr )
+        : _owner( owner ), _leaf_type( leaf_type ), _node_cb( node_cb ), _cache( cache ) {
+        }
+
+        /*! \brief Begins a new traversal.
+         */
+        LeafInstanceIterator begin( void ) const {
+            return LeafInstanceIterator( _owner, _leaf_type, _node_cb, _cache );
+        }
+
+        /*! \brief The past the end iterator.
+         */
+        LeafInstanceIterator end( void ) const {
+            return LeafInstanceIterator();
+        }
+
+    private:
+        A3DEntity *_owner;
+        A3DEEntityType _leaf_type;
+        TraversalCallback _node_cb;
+        TraversalCache *_cache;
+    };
+
+    /*! \brief Lazily enumerates the instance paths from \c owner to all leaf
+     * entities of type \c leaf_type.
+     *
+     * This is the streaming counterpart to getLeafInstances(). Paths are produced
+     * on demand, in the same order, and the consumer may stop at any time without
+     * paying for the remainder of the traversal.
+     * \code
+     * for( auto const &face_path : ts3d::leafInstances( model_file, kA3DTypeTopoFace ) ) {
+     *     if( processFace( face_path ) ) {
+     *         break;
+     *     }
+     * }
+     * \endcode
+     * \param owner The top level object to begin traversal.
+     * \param leaf_type The type of child node to look for.
+     * \ingroup traversal
+     */
+    static inline LeafInstanceRange leafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
+        return LeafInstanceRange( owner, leaf_type );
+    }
+
+    /*! \brief Lazily enumerates the instance paths from \c owner to all leaf
+     * entities of type \c leaf_type, pruning the traversal using \c node_cb.
+     * \sa visitLeafInstances
+     * \ingroup traversal
+     */
+    static inline LeafInstanceRange leafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCallback const &node_cb ) {
+        return LeafInstanceRange( owner, leaf_type, node_cb );
+    }
+
+    /*! \brief Lazily enumerates the instance paths from \c owner to all leaf
+     * entities of type \c leaf_type, obtaining the children of each entity from \c cache.
+     * \sa TraversalCache
+     * \ingroup traversal
+     */
+    static inline LeafInstanceRange leafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCache &cache ) {
+        return LeafInstanceRange( owner, leaf_type, TraversalCallback(), &cache );
+    }
+
+}
+
+ts3d::InstancePathArray ts3d::getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
+    InstancePathArray result;
+    for( auto const &instance_path : leafInstances( owner, leaf_type ) ) {
+        result.push_back( instance_path );
+        TS3D_INSTRUMENT( Instrumentation::recordPathBytes( result.back().capacity() * sizeof( A3DEntity* ) ) );
+    }
+    return result;
+}
+
+ts3d::InstancePathsByType ts3d::getLeafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types ) {
+    // Paths are gathered per type path so that the result for each leaf type
+    // is ordered as it would be if traversed separately
+    std::vector<std::vector<InstancePathArray>> paths_by_type_path( leaf_types.size() );
+    auto const range = leafInstances( owner, leaf_types );
+    for( auto it = range.begin(); it != range.end(); ++it ) {
+        auto &paths = paths_by_type_path[it.leafTypeIndex()];
+        if( paths.size() <= it.typePathIndex() ) {
+            paths.resize( it.typePathIndex() + 1u );
+        }
+        paths[it.typePathIndex()].push_back( *it );
+        TS3D_INSTRUMENT( Instrumentation::recordPathBytes( paths[it.typePathIndex()].back().capacity() * sizeof( A3DEntity* ) ) );
+    }
+
+    InstancePathsByType result;
+    for( auto leaf_type_idx = 0u; leaf_type_idx < leaf_types.size(); ++leaf_type_idx ) {
+        if( result.count( leaf_types[leaf_type_idx] ) ) {
+            continue;
+        }
+        auto &leaf_type_result = result[leaf_types[leaf_type_idx]];
+        for( auto &paths : paths_by_type_path[leaf_type_idx] ) {
+            std::move( paths.begin(), paths.end(), std::back_inserter( leaf_type_result ) );
+        }
+    }
+    return result;
+}
+
+bool ts3d::visitLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCallback const &node_cb, TraversalCallback const &leaf_cb ) {
+    auto stopped = false;
+    auto const stop_cb = [&stopped, &node_cb]( InstancePath const &instance_path ) {
+        auto const action = node_cb ? node_cb( instance_path ) : TraversalAction::Continue;
+        stopped = stopped || TraversalAction::Stop == action;
+        return action;
+    };
+    for( auto const &instance_path : leafInstances( owner, EntityTypeArray( 1, leaf_type ), stop_cb ) ) {
+        if( leaf_cb && TraversalAction::Stop == leaf_cb( instance_path ) ) {
+            return false;
+        }
+    }
+    return !stopped;
+}
+
+namespace {
+    // The portion of a parallel traversal below a single entity. Product
+    // occurrences found below it are traversed as separate units, and their
+    // results belong before the result at the recorded position in the parent.
+    struct ParallelTraversalUnit {
+        InstancePath _base_path;
+        A3DEntity *_ntt;
+        size_t _node;
+        InstancePathArray _paths;
+        std::vector<size_t> _type_path_indices;
+        EntityArray _leaves;
+        std::vector<std::unique_ptr<ParallelTraversalUnit>> _children;
+        std::vector<size_t> _child_positions;
+    };
+
+    // Traverses the hierarchy below owner using a TaskGroup in which each
+    // product occurrence is a task, spawned by the task that reaches it. If
+    // keep_paths is false only the unique leaf entities of each unit are
+    // recorded, and product occurrences reached more than once at the same
+    // type tree node are traversed once.
+    class ParallelTraversal {
+    public:
+        ParallelTraversal( A3DEntity *owner, A3DEEntityType const &leaf_type, unsigned int const thread_count, bool const keep_paths )
+        : _leaf_types( 1, leaf_type ), _keep_paths( keep_paths ), _group( thread_count ) {
+            _tree = std::make_shared<TypeTree const>( getBaseType( getEntityType( owner ) ), _leaf_types );
+            _root._ntt = owner;
+            _root._node = 0u;
+            auto const root = &_root;
+            _group.spawn( [this, root]() {
+                traverse( *root );
+            });
+            _group.wait();
+        }
+
+        // Moves the instance paths into result, in the order of getLeafInstances()
+        void takePaths( InstancePathArray &result ) {
+            std::vector<InstancePathArray> paths_by_type_path;
+            takePaths( _root, paths_by_type_path );
+            auto total_size = size_t( 0u );
+            for( auto const &paths : paths_by_type_path ) {
+                total_size += paths.size();
             }
-        },
-        {
-            kA3DTypeTopoSingleWireBody,
-            {
-                {
-                    kA3DTypeTopoWireEdge,
-                    []( A3DEntity *ntt ) {
-                        A3DTopoSingleWireBodyWrapper d( ntt );
-                        return EntityArray( 1, d->m_pWireEdge );
-                    }
-                }
+            result.reserve( result.size() + total_size );
+            for( auto &paths : paths_by_type_path ) {
+                std::move( paths.begin(), paths.end(), std::back_inserter( result ) );
             }
-        },
-        {
-            kA3DTypeMkpAnnotationEntity,
-            {
-                {
-                    kA3DTypeMkpAnnotationEntity,
-                    []( A3DEntity *ntt ) {
-                        if( kA3DTypeMkpAnnotationSet == getEntityType( ntt ) ) {
-                            A3DMkpAnnotationSetWrapper d( ntt );
-                            return toVector( d->m_ppAnnotations, d->m_uiAnnotationsSize );
-                        }
-                        return EntityArray();
-                    }
-                },
-                {
-                    kA3DTypeMiscMarkupLinkedItem,
-                    []( A3DEntity *ntt ) {
-                        if( kA3DTypeMkpAnnotationReference == getEntityType( ntt ) ) {
-                            A3DMkpAnnotationReferenceWrapper d( ntt );
-                            return toVector( d->m_ppLinkedItems, d->m_uiLinkedItemsSize );
-                        }
-                        return EntityArray();
-                    }
-                },
-                {
-                    kA3DTypeMkpMarkup, // Base type, matches all markups
-                    []( A3DEntity *ntt ) {
-                        if( kA3DTypeMkpAnnotationItem == getEntityType( ntt ) ) {
-                            A3DMkpAnnotationItemWrapper d( ntt );
-                            return EntityArray( 1, d->m_pMarkup );
-                        }
-                        return EntityArray();
-                    }
+        }
+
+        // Inserts the leaf entities of all units into result
+        void takeLeaves( EntitySet &result ) {
+            std::vector<ParallelTraversalUnit*> units( 1, &_root );
+            while( !units.empty() ) {
+                auto const unit = units.back();
+                units.pop_back();
+                result.insert( unit->_leaves.begin(), unit->_leaves.end() );
+                EntityArray().swap( unit->_leaves );
+                for( auto const &child : unit->_children ) {
+                    units.push_back( child.get() );
                 }
             }
-        },
-        {
-            kA3DTypeMkpMarkup,
-            {
-                {
-                    kA3DTypeMiscMarkupLinkedItem,
-                    []( A3DEntity *ntt ) {
-                        A3DMkpMarkupWrapper d( ntt );
-                        return toVector( d->m_ppLinkedItems, d->m_uiLinkedItemsSize );
-                    }
-                },
-                {
-                    kA3DTypeMkpLeader,
-                    []( A3DEntity *ntt ) {
-                        A3DMkpMarkupWrapper d( ntt );
-                        return toVector( d->m_ppLeaders, d->m_uiLeadersSize );
+        }
+
+    private:
+        void traverse( ParallelTraversalUnit &unit ) {
+            for( MultiLeafInstanceIterator it( _tree, _leaf_types, unit._base_path, unit._ntt, unit._node, true ); it != MultiLeafInstanceIterator(); ++it ) {
+                if( it.isSubtree() ) {
+                    if( !_keep_paths && !firstVisit( it->back(), it.subtreeNode() ) ) {
+                        continue;
                     }
+                    unit._children.emplace_back( new ParallelTraversalUnit() );
+                    unit._child_positions.push_back( unit._paths.size() );
+                    auto const child = unit._children.back().get();
+                    child->_base_path.assign( it->begin(), it->end() - 1 );
+                    child->_ntt = it->back();
+                    child->_node = it.subtreeNode();
+                    _group.spawn( [this, child]() {
+                        traverse( *child );
+                    });
+                } else if( _keep_paths ) {
+                    unit._paths.push_back( *it );
+                    unit._type_path_indices.push_back( it.typePathIndex() );
+                } else {
+                    unit._leaves.push_back( it->back() );
                 }
             }
+            if( !_keep_paths ) {
+                std::sort( unit._leaves.begin(), unit._leaves.end() );
+                unit._leaves.erase( std::unique( unit._leaves.begin(), unit._leaves.end() ), unit._leaves.end() );
+                unit._leaves.shrink_to_fit();
+            }
         }
-    };
-    
-    // For an entity type child_type, this function returns
-    // a list of entity types that can contain the child type
-    static inline TypeSet getPossibleParents( A3DEEntityType const &child_type ) {
-        static std::unordered_map<A3DEEntityType, TypeSet> _cache;
-        auto const it = _cache.find( child_type );
-        if( std::end( _cache ) != it ) {
-            return it->second;
+
+        bool firstVisit( A3DEntity *ntt, size_t const node ) {
+            std::lock_guard<std::mutex> const lock( _visited_mutex );
+            return _visited.emplace( ntt, node ).second;
         }
-        
-        TypeSet possible_parents;
-        for( auto const &owning_type_entry : _getterMapByType ) {
-            auto const &owning_type = owning_type_entry.first;
-            for( auto const &child_type_entry : owning_type_entry.second ) {
-                if( child_type_entry.first == child_type ) {
-                    possible_parents.insert( owning_type );
-                    break;
+
+        // Gathers paths per type path, so that each leaf is ordered as it
+        // would be if the type paths were traversed one after another
+        static void takePaths( ParallelTraversalUnit &unit, std::vector<InstancePathArray> &paths_by_type_path ) {
+            auto next_child = size_t( 0u );
+            for( auto idx = size_t( 0u ); idx <= unit._paths.size(); ++idx ) {
+                while( next_child < unit._children.size() && unit._child_positions[next_child] == idx ) {
+                    takePaths( *unit._children[next_child++], paths_by_type_path );
+                }
+                if( idx < unit._paths.size() ) {
+                    auto const type_path_idx = unit._type_path_indices[idx];
+                    if( paths_by_type_path.size() <= type_path_idx ) {
+                        paths_by_type_path.resize( type_path_idx + 1u );
+                    }
+                    paths_by_type_path[type_path_idx].push_back( std::move( unit._paths[idx] ) );
                 }
             }
+            InstancePathArray().swap( unit._paths );
         }
-        _cache[child_type] = possible_parents;
-        return possible_parents;
+
+        EntityTypeArray const _leaf_types;
+        bool const _keep_paths;
+        std::shared_ptr<TypeTree const> _tree;
+        TaskGroup _group;
+        ParallelTraversalUnit _root;
+        std::mutex _visited_mutex;
+        std::set<std::pair<A3DEntity*, size_t>> _visited;
+    };
+}
+
+ts3d::InstancePathArray ts3d::getLeafInstancesParallel( A3DEntity *owner, A3DEEntityType const &leaf_type, unsigned int thread_count ) {
+    InstancePathArray result;
+    ParallelTraversal( owner, leaf_type, thread_count, true ).takePaths( result );
+    TS3D_INSTRUMENT( for( auto const &instance_path : result ) { Instrumentation::recordPathBytes( instance_path.capacity() * sizeof( A3DEntity* ) ); } );
+    return result;
+}
+
+ts3d::EntitySet ts3d::getUniqueLeafEntitiesParallel( A3DEntity *owner, A3DEEntityType const &leaf_type, unsigned int thread_count ) {
+    EntitySet result;
+    ParallelTraversal( owner, leaf_type, thread_count, false ).takeLeaves( result );
+    return result;
+}
+
+ts3d::EntitySet ts3d::getUniqueLeafEntitiesParallel( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathMap &instance_path_map, unsigned int thread_count ) {
+    EntitySet result;
+    auto paths = getLeafInstancesParallel( owner, leaf_type, thread_count );
+    for( auto &path : paths ) {
+        result.insert( path.back() );
+        instance_path_map[path.back()].emplace_back( std::move( path ) );
     }
-    
-    // Since some entity types "derived", this function is a helper
-    // used to obtain a "base" type for entity_type
-    static inline A3DEEntityType getBaseType( A3DEEntityType const &entity_type ) {
-        auto base_type = entity_type;
-        if( isRepresentationItem( entity_type ) ) {
-            base_type = kA3DTypeRiRepresentationItem;
-        } else if( isTessBase( entity_type ) ) {
-            base_type = kA3DTypeTessBase;
-        } else if( kA3DTypeTopoUniqueVertex == entity_type || kA3DTypeTopoMultipleVertex == entity_type ) {
-            base_type = kA3DTypeTopoVertex;
-        } else if( isAnnotationEntity( entity_type ) ) {
-            base_type = kA3DTypeMkpAnnotationEntity;
-        } else if( isMarkup( entity_type ) ) {
-            base_type = kA3DTypeMkpMarkup;
+    return result;
+}
+
+namespace {
+    // Walks the hierarchy below owner as a directed acyclic graph. Each entity
+    // is expanded once for each node of the type tree it is reached at, no
+    // matter how many instance paths lead to it. The number of instance paths
+    // reaching each entity is obtained by propagating counts through the graph
+    // in topological order. leaf_fn( ntt, leaf_type_idx, instance_count ) is
+    // invoked for each leaf found, once per type tree node it is reached at.
+    static inline void visitLeafEntityGraph( A3DEntity *owner, EntityTypeArray const &leaf_types, TraversalCache *cache, std::function<void( A3DEntity*, size_t, size_t )> const &leaf_fn ) {
+        TypeTree const tree( getBaseType( getEntityType( owner ) ), leaf_types );
+        if( tree._nodes.front()._branches.empty() ) {
+            return;
         }
-        return base_type;
-    }
-    
-    // This function can be used to obtain a set of type paths where the parent type
-    // and leaf child type values are both given. Each type path returned is one
-    // possible way to traverse the Exchange data structures such that the beginning
-    // entity type and ending entity type are equal to the input parameters.
-    static TypePathArray getPossibleTypePaths( A3DEEntityType const &parent_type, A3DEEntityType const &child_type ) {
-        
-        // check to see if the given owner and child type values are present in the cache
-        static std::unordered_map< A3DEEntityType, std::unordered_map< A3DEEntityType, TypePathArray >> _cache;
-        auto const parent_type_it = _cache.find( parent_type );
-        if(std::end( _cache ) != parent_type_it ) {
-            auto const child_type_it = parent_type_it->second.find( child_type );
-            if( std::end( parent_type_it->second ) != child_type_it ) {
-                return child_type_it->second;
+
+        struct State {
+            A3DEntity *_ntt;
+            size_t _node;
+            size_t _edges_begin;
+            size_t _edges_end;
+            bool _expanded;
+        };
+        using StateKey = std::pair<A3DEntity*, size_t>;
+        struct StateKeyHash {
+            size_t operator()( StateKey const &key ) const noexcept {
+                return std::hash<A3DEntity*>()( key.first ) ^ (key.second << 1);
             }
-        }
-        
-        // result is not present in the cache, so compute it
-        TypePathArray type_paths;
-        auto const possible_parents = getPossibleParents( child_type );
-        if( std::end( possible_parents ) != possible_parents.find( parent_type ) ) {
-            // child entity type is an immediate child of parent entity type
-            TypePath type_path;
-            type_path.push_back( parent_type );
-            type_path.push_back( child_type );
-            type_paths.push_back( type_path );
-        } else {
-            // child entity type is not an immediate child of parent entity type
-            // so we must iterate over the list of all possible parent types
-            // and for each of those parent types, examine up the ownership chain
-            for( auto const intermediate_parent_type : possible_parents ) {
-                if( intermediate_parent_type != child_type ) {
-                    auto const intermediate_type_paths = getPossibleTypePaths( parent_type, intermediate_parent_type );
-                    for( auto const &intermediate_type_path : intermediate_type_paths ) {
-                        type_paths.push_back( intermediate_type_path );
-                        type_paths.back().push_back( child_type );
-                    }
-                }
+        };
+        std::vector<State> states;
+        std::unordered_map<StateKey, size_t, StateKeyHash> state_ids;
+        std::vector<size_t> edges;
+        std::vector<std::pair<size_t, size_t>> leaves;
+        EntityArray children;
+
+        auto const getStateId = [&states, &state_ids]( A3DEntity *ntt, size_t const node_idx ) {
+            auto const result = state_ids.emplace( StateKey( ntt, node_idx ), states.size() );
+            if( result.second ) {
+                states.push_back( { ntt, node_idx, 0u, 0u, false } );
             }
-        }
-        // augment the cache
+            return result.first->second;
+        };
 
-        _cache[parent_type][child_type] = type_paths;
-        return type_paths;
-    }
-    
-    static ts3d::InstancePathArray getInstancePaths( A3DEntity *owner, TypePath const &type_path, ts3d::InstancePath const &instance_path = ts3d::InstancePath() )  {
-        ts3d::InstancePathArray instance_paths;
-        auto const owner_type = ts3d::getEntityType( owner );
-        auto const owner_base_type = getBaseType( owner_type );
-        auto const owner_decomposer_it = _getterMapByType.find( owner_base_type );
-        auto base_instance_path = instance_path;
-        base_instance_path.push_back( owner );
+        // Obtains the children of ntt and records an edge to each
+        auto const addEdges = [&]( A3DEntity *ntt, A3DEEntityType const &child_base_type, ChildGetter const getter, size_t const child_node_idx ) {
+            children.clear();
+            if( nullptr != cache ) {
+                cache->append( ntt, child_base_type, getter, children );
+            } else if( nullptr != getter ) {
+                getter( ntt, children );
+            }
+            for( auto const child : children ) {
+                edges.push_back( getStateId( child, child_node_idx ) );
+            }
+        };
 
-        if(std::end( _getterMapByType ) == owner_decomposer_it ) {
-            if( type_path.size() == 1 && owner_base_type == type_path.back() ) {
-                instance_paths.push_back( base_instance_path );
+        // Mirrors the decisions made by the leaf instance iterators for a single entity
+        auto const expand = [&]( size_t const state_id ) {
+            auto const ntt = states[state_id]._ntt;
+            auto const node_idx = states[state_id]._node;
+            auto const &node = tree._nodes[node_idx];
+            auto const ntt_type = getEntityType( ntt );
+            auto const base_type = getBaseType( ntt_type );
+            auto const on_type_path = base_type == node._type;
+            auto const edges_begin = edges.size();
+            auto report_leaves = true;
+            auto descend = true;
+            if( !(on_type_path ? node._has_decomposition : hasDecomposition( base_type )) ) {
+                report_leaves = on_type_path;
+                descend = false;
+            } else if( kA3DTypeAsmProductOccurrence == base_type ) {
+                addEdges( ntt, kA3DTypeAsmProductOccurrence, &getProductOccurrenceProductOccurrences, node_idx );
+            } else if( kA3DTypeRiSet == ntt_type ) {
+                addEdges( ntt, kA3DTypeRiRepresentationItem, &getRepresentationItemRepresentationItems, node_idx );
+                report_leaves = descend = edges.size() == edges_begin;
+            } else if( kA3DTypeMkpAnnotationSet == ntt_type ) {
+                addEdges( ntt, kA3DTypeMkpAnnotationEntity, &getAnnotationEntityAnnotationEntities, node_idx );
             }
-            return instance_paths;
-        }
-        
-        
-        if( kA3DTypeAsmProductOccurrence == owner_base_type ) {
-            auto const children = owner_decomposer_it->second[kA3DTypeAsmProductOccurrence]( owner );
-            if( !children.empty() ) {
-                for( auto child : children ) {
-                    auto const child_instance_paths = getInstancePaths( child, type_path, base_instance_path );
-                    std::copy( child_instance_paths.begin(), child_instance_paths.end(), std::back_inserter( instance_paths ) );
+            if( report_leaves ) {
+                for( auto const &leaf : node._leaves ) {
+                    if( isLeafOfType( ntt, leaf_types[leaf._leaf_type_idx] ) ) {
+                        leaves.emplace_back( state_id, leaf._leaf_type_idx );
+                    }
                 }
             }
-        } else if( kA3DTypeRiSet == owner_type ) {
-            auto const children = owner_decomposer_it->second[kA3DTypeRiRepresentationItem]( owner );
-            if( !children.empty() ) {
-                for( auto child : children ) {
-                    auto const child_instance_paths = getInstancePaths( child, type_path, base_instance_path );
-                    std::copy( child_instance_paths.begin(), child_instance_paths.end(), std::back_inserter( instance_paths ) );
+            if( descend ) {
+                for( auto const branch_idx : node._branches ) {
+                    auto const &branch = tree._nodes[branch_idx];
+                    addEdges( ntt, branch._type, on_type_path ? branch._getter : getChildGetter( base_type, branch._type ), branch_idx );
                 }
-                return instance_paths;
-            }
-        } else if( kA3DTypeMkpAnnotationSet == owner_type ) {
-            auto const children = owner_decomposer_it->second[kA3DTypeMkpAnnotationEntity]( owner );
-            if( !children.empty() ) {
-                for( auto child : children ) {
-                    auto const child_instance_paths = getInstancePaths( child, type_path, base_instance_path );
-                    std::copy( child_instance_paths.begin(), child_instance_paths.end(), std::back_inserter( instance_paths ) );
+            }
+            states[state_id]._edges_begin = edges_begin;
+            states[state_id]._edges_end = edges.size();
+            states[state_id]._expanded = true;
+        };
+
+        // Depth first walk, recording the states in post order
+        std::vector<size_t> post_order;
+        std::vector<std::pair<size_t, size_t>> stack;
+        auto const root_id = getStateId( owner, 0u );
+        expand( root_id );
+        stack.emplace_back( root_id, states[root_id]._edges_begin );
+        while( !stack.empty() ) {
+            auto const state_id = stack.back().first;
+            auto const edge_idx = stack.back().second;
+            if( edge_idx < states[state_id]._edges_end ) {
+                ++stack.back().second;
+                auto const child_id = edges[edge_idx];
+                if( !states[child_id]._expanded ) {
+                    expand( child_id );
+                    stack.emplace_back( child_id, states[child_id]._edges_begin );
                 }
+            } else {
+                post_order.push_back( state_id );
+                stack.pop_back();
             }
         }
-        
-        TypePath const child_type_path( type_path.begin() + 1, type_path.end() );
-        if(child_type_path.empty()) {
-            instance_paths.push_back( base_instance_path );
-            return instance_paths;
+
+        // Reverse post order is a topological order, so each state's count
+        // is final before it is propagated to its children
+        std::vector<size_t> instance_counts( states.size(), 0u );
+        instance_counts[root_id] = 1u;
+        for( auto it = post_order.rbegin(); it != post_order.rend(); ++it ) {
+            auto const &state = states[*it];
+            for( auto edge_idx = state._edges_begin; edge_idx < state._edges_end; ++edge_idx ) {
+                instance_counts[edges[edge_idx]] += instance_counts[*it];
+            }
         }
-        auto const children = owner_decomposer_it->second[child_type_path.front()]( owner );
-        for(auto child : children ) {
-            auto const child_instance_paths = getInstancePaths( child, child_type_path, base_instance_path );
-            std::copy( child_instance_paths.begin(), child_instance_paths.end(), std::back_inserter( instance_paths ) );
+
+        for( auto const &leaf : leaves ) {
+            leaf_fn( states[leaf.first]._ntt, leaf.second, instance_counts[leaf.first] );
         }
-        return instance_paths;
     }
 }
 
-ts3d::InstancePathArray ts3d::getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
+ts3d::EntitySet ts3d::getUniqueParts( A3DAsmModelFile *modelFile ) {
+    return getUniqueLeafEntities( modelFile, kA3DTypeAsmPartDefinition );
+}
+
+ts3d::FlatEntitySet ts3d::getUniqueLeafEntitiesFlat( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
+    EntityArray result;
+    visitLeafEntityGraph( owner, EntityTypeArray( 1, leaf_type ), nullptr, [&result]( A3DEntity *ntt, size_t, size_t ) {
+        result.push_back( ntt );
+    });
+    return FlatEntitySet( std::move( result ) );
+}
+
+ts3d::FlatEntitySet ts3d::getUniqueLeafEntitiesFlat( A3DEntity *owner, A3DEEntityType const &leaf_type, FlatInstancePathMap &instance_path_map ) {
+    instance_path_map = FlatInstancePathMap( leafInstances( owner, leaf_type ) );
+    return FlatEntitySet( instance_path_map.keys() );
+}
+
+ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
+    return getUniqueLeafEntitiesFlat( owner, leaf_type ).toEntitySet();
+}
+
+size_t ts3d::countLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
+    auto result = size_t( 0u );
+    visitLeafEntityGraph( owner, EntityTypeArray( 1, leaf_type ), nullptr, [&result]( A3DEntity *, size_t, size_t const instance_count ) {
+        result += instance_count;
+    });
+    return result;
+}
+
+size_t ts3d::countLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, InstanceCountMap &instance_counts ) {
+    auto result = size_t( 0u );
+    visitLeafEntityGraph( owner, EntityTypeArray( 1, leaf_type ), nullptr, [&result, &instance_counts]( A3DEntity *ntt, size_t, size_t const instance_count ) {
+        result += instance_count;
+        instance_counts[ntt] += instance_count;
+    });
+    return result;
+}
+
+ts3d::InstanceCountsByType ts3d::countLeafInstances( A3DEntity *owner, EntityTypeArray const &leaf_types ) {
+    InstanceCountsByType result;
+    for( auto const leaf_type : leaf_types ) {
+        result[leaf_type] = 0u;
+    }
+    visitLeafEntityGraph( owner, leaf_types, nullptr, [&result, &leaf_types]( A3DEntity *, size_t const leaf_type_idx, size_t const instance_count ) {
+        result[leaf_types[leaf_type_idx]] += instance_count;
+    });
+    return result;
+}
+
+ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstanceCountMap &instance_counts ) {
+    EntitySet result;
+    visitLeafEntityGraph( owner, EntityTypeArray( 1, leaf_type ), nullptr, [&result, &instance_counts]( A3DEntity *ntt, size_t, size_t const instance_count ) {
+        result.insert( ntt );
+        instance_counts[ntt] += instance_count;
+    });
+    return result;
+}
+
+ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathMap &instance_path_map ) {
+    EntitySet result;
+    for( auto const &instance_path : leafInstances( owner, leaf_type ) ) {
+        result.insert( instance_path.back() );
+        instance_path_map[instance_path.back()].push_back( instance_path );
+    }
+    return result;
+}
+
+ts3d::InstancePathArray ts3d::getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCache &cache ) {
     InstancePathArray result;
-    auto const owner_base_type = getBaseType( getEntityType( owner ) );
-    auto const leaf_base_type = getBaseType( leaf_type );
-    
-    auto const possible_type_paths = getPossibleTypePaths( owner_base_type, leaf_base_type );
-    for( auto const &possible_type_path : possible_type_paths ) {
-        if( possible_type_path.empty() ) {
-            continue;
-        }
-        auto const instance_paths = getInstancePaths( owner, possible_type_path );
-        if( leaf_base_type != leaf_type ) {
-            std::copy_if( instance_paths.begin(), instance_paths.end(), std::back_inserter( result ),
-                         [leaf_type](InstancePath const &instance_path) {
-                             auto const leaf_entity = instance_path.back();
-                             return getEntityType( leaf_entity ) == leaf_type;
-                         });
-        } else {
-            std::copy( instance_paths.begin(), instance_paths.end(), std::back_inserter( result ) );
-        }
+    for( auto const &instance_path : leafInstances( owner, leaf_type, cache ) ) {
+        result.push_back( instance_path );
+        TS3D_INSTRUMENT( Instrumentation::recordPathBytes( result.back().capacity() * sizeof( A3DEntity* ) ) );
     }
-    
     return result;
 }
 
-ts3d::EntitySet ts3d::getUniqueParts( A3DAsmModelFile *modelFile ) {
-    return getUniqueLeafEntities( modelFile, kA3DTypeAsmPartDefinition );
+ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, TraversalCache &cache ) {
+    EntitySet result;
+    visitLeafEntityGraph( owner, EntityTypeArray( 1, leaf_type ), &cache, [&result]( A3DEntity *ntt, size_t, size_t ) {
+        result.insert( ntt );
+    });
+    return result;
 }
 
-ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type ) {
+ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathMap &instance_path_map, TraversalCache &cache ) {
     EntitySet result;
-    auto const paths = getLeafInstances( owner, leaf_type );
-    for( auto path : paths ) {
-        result.insert( path.back() );
+    for( auto const &instance_path : leafInstances( owner, leaf_type, cache ) ) {
+        result.insert( instance_path.back() );
+        instance_path_map[instance_path.back()].push_back( instance_path );
     }
     return result;
 }
 
-ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathMap &instance_path_map ) {
+ts3d::InstancePathHandleArray ts3d::getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathTree &tree ) {
+    InstancePathHandleArray result;
+    for( auto const &instance_path : leafInstances( owner, leaf_type ) ) {
+        result.push_back( tree.add( instance_path ) );
+    }
+    return result;
+}
+
+ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, InstancePathTree &tree, InstancePathHandleMap &instance_path_map ) {
     EntitySet result;
-    auto const paths = getLeafInstances( owner, leaf_type );
-    for( auto path : paths) {
-        result.insert( path.back() );
-        instance_path_map[path.back()].emplace_back( path );
+    for( auto const &instance_path : leafInstances( owner, leaf_type ) ) {
+        result.insert( instance_path.back() );
+        instance_path_map[instance_path.back()].push_back( tree.add( instance_path ) );
+    }
+    return result;
+}
+
+ts3d::InstancePathHandleArray ts3d::getLeafInstances( A3DEntity *owner, A3DEEntityType const &leaf_type, PathInterner &interner ) {
+    InstancePathHandleArray result;
+    for( auto const &instance_path : leafInstances( owner, leaf_type ) ) {
+        result.push_back( interner.intern( instance_path ) );
+    }
+    return result;
+}
+
+ts3d::EntitySet ts3d::getUniqueLeafEntities( A3DEntity *owner, A3DEEntityType const &leaf_type, PathInterner &interner, InstancePathHandleMap &instance_path_map ) {
+    EntitySet result;
+    for( auto const &instance_path : leafInstances( owner, leaf_type ) ) {
+        result.insert( instance_path.back() );
+        instance_path_map[instance_path.back()].push_back( interner.intern( instance_path ) );
     }
     return result;
 }
@@ -1605,22 +4311,38 @@ ts3d::InstancePath ts3d::getOwningInstance( InstancePath const &instance_path, A
     return result;
 }
 
+namespace {
+    // Obtains the children of owner, optionally using a traversal cache,
+    // and removes those that are not of child_type
+    static inline EntityArray fetchChildren( A3DEntity *owner, A3DEEntityType const &child_type, TraversalCache *cache ) {
+        auto const owner_base_type = getBaseType( getEntityType( owner ) );
+        auto const child_base_type = getBaseType( child_type );
+        
+        EntityArray result;
+        auto const getter = getChildGetter( owner_base_type, child_base_type );
+        if( nullptr == getter ) {
+            return result;
+        }
+        if( nullptr != cache ) {
+            cache->append( owner, child_base_type, getter, result );
+        } else {
+            getter( owner, result );
+        }
+        if( child_type != child_base_type ) {
+            result.erase( std::remove_if( std::begin( result ), std::end( result ), [child_type]( A3DEntity *child ) {
+                return getEntityType( child ) != child_type;
+            }), std::end( result ) );
+        }
+        return result;
+    }
+}
+
 ts3d::EntityArray ts3d::getChildren( A3DEntity *owner, A3DEEntityType const &child_type ) {
-    auto const owner_type = ts3d::getEntityType( owner );
-    auto const owner_base_type = getBaseType( owner_type );
-    auto const child_base_type = getBaseType( child_type );
-    auto const owner_decomposer_it = _getterMapByType.find( owner_base_type );
-    
-    EntityArray result;
-	auto const decomposer_it = owner_decomposer_it->second.find(child_base_type);
-	if (std::end(owner_decomposer_it->second) == decomposer_it) {
-		return result;
-	}
-    auto const children = decomposer_it->second( owner );
-    std::copy_if( std::begin( children ), std::end( children ), std::back_inserter( result ), [child_type, child_base_type]( A3DEntity *child ) {
-        return child_type == child_base_type || getEntityType( child ) == child_type;
-    });
-    return result;
+    return fetchChildren( owner, child_type, nullptr );
+}
+
+ts3d::EntityArray ts3d::getChildren( A3DEntity *owner, A3DEEntityType const &child_type, TraversalCache &cache ) {
+    return fetchChildren( owner, child_type, &cache );
 }
 
 
@@ -1648,18 +4370,32 @@ namespace ts3d {
         : _path( path ) {
         }
 
+        /*! \brief Constructs an Instance by expanding an instance path stored in an InstancePathTree
+         */
+        Instance( InstancePathTree const &tree, InstancePathHandle const handle )
+        : _path( tree.expand( handle ) ) {
+        }
+
+        /*! \brief Constructs an Instance from a handle obtained from a PathInterner.
+         * Instances constructed from the same interner are compared by handle
+         * rather than by path. The interner must outlive the Instance.
+         */
+        Instance( PathInterner const &interner, InstancePathHandle const handle )
+        : _path( interner.expand( handle ) ), _interner( &interner ), _handle( handle ) {
+        }
+
         
         /*! \brief Copy constructor
          */
         Instance( Instance const &other )
-        : _path( other._path ) {
+        : _path( other._path ), _interner( other._interner ), _handle( other._handle ) {
         }
 
         
         /*! \brief Move constructor
          */
         Instance( Instance &&other )
-        : _path( std::move( other._path ) ) {
+        : _path( std::move( other._path ) ), _interner( other._interner ), _handle( other._handle ) {
         }
 
         
@@ -1673,6 +4409,8 @@ namespace ts3d {
          */
         Instance &operator=( Instance const &other ) {
             _path = other._path;
+            _interner = other._interner;
+            _handle = other._handle;
             return *this;
         }
         
@@ -1680,14 +4418,34 @@ namespace ts3d {
          */
         Instance &operator=( Instance &&other ) {
             _path = std::move( other._path );
+            _interner = other._interner;
+            _handle = other._handle;
             return *this;
         }
 
-        /*! \brief Compare paths
+        /*! \brief Compare paths. Instances constructed from handles of the
+         * same PathInterner are compared in constant time.
          */
         bool operator==( Instance const &other ) const {
+            if( nullptr != _interner && _interner == other._interner ) {
+                return _handle == other._handle;
+            }
             return _path == other._path;
         }
+
+        /*! \brief Gets the PathInterner this Instance was constructed from, or
+         * \c nullptr if it was constructed from a path.
+         */
+        PathInterner const *interner( void ) const {
+            return _interner;
+        }
+
+        /*! \brief Gets the handle this Instance was constructed from, or
+         * PathInterner::invalidHandle() if it was constructed from a path.
+         */
+        InstancePathHandle handle( void ) const {
+            return _handle;
+        }
         
         /*! \brief Gets the object name
          */
@@ -1698,7 +4456,9 @@ namespace ts3d {
         /*! \brief Gets the object type as a string
          */
         std::string getType( void ) const {
-            return A3DMiscGetEntityTypeMsg( leafType() );
+            auto const type = leafType();
+            ApiLock const lock;
+            return A3DMiscGetEntityTypeMsg( type );
         }
 
         /*! \brief Gets the InstancePath this Instance references
@@ -1713,6 +4473,9 @@ namespace ts3d {
             if( _path.size() < 2 ) {
                 return Instance( InstancePath() );
             }
+            if( nullptr != _interner ) {
+                return Instance( *_interner, _interner->parent( _handle ) );
+            }
             auto owner_path = _path;
             owner_path.pop_back();
             return Instance( owner_path );
@@ -1727,7 +4490,10 @@ namespace ts3d {
             }
             
             _path = new_path;
+            _interner = nullptr;
+            _handle = PathInterner::invalidHandle();
             
+            ApiLock const lock;
             for( auto attrib : _cascaded_attribs ) {
                 A3DMiscCascadedAttributesDelete( attrib );
             }
@@ -1789,6 +4555,7 @@ namespace ts3d {
         /*! \private */
         A3DMiscCascadedAttributes *getCascadedAttributes( void ) const {
             if(_cascaded_attribs.empty() ) {
+                ApiLock const lock;
                 _cascaded_attribs.push_back( nullptr );
                 CheckResult( A3DMiscCascadedAttributesCreate( &_cascaded_attribs.back() ) );
                 for( auto ntt : _path ) {
@@ -1803,15 +4570,207 @@ namespace ts3d {
                     _cascaded_attribs_data.reset( _cascaded_attribs.back() );
                 }
             }
-            return _cascaded_attribs.empty() ? nullptr : _cascaded_attribs.back();
+            return _cascaded_attribs.empty() ? nullptr : _cascaded_attribs.back();
+        }
+        
+        /*! \private */
+        InstancePath _path;
+        /*! \private */
+        PathInterner const *_interner = nullptr;
+        /*! \private */
+        InstancePathHandle _handle = PathInterner::invalidHandle();
+        /*! \private */
+        mutable std::vector<A3DMiscCascadedAttributes*> _cascaded_attribs;
+        /*! \private */
+        mutable A3DMiscCascadedAttributesWrapper _cascaded_attribs_data;
+    };
+
+    /*! \brief The net attributes of an instance, as obtained from its cascaded attributes.
+     * \sa CascadedAttributesCache
+     * \ingroup access
+     */
+    struct NetAttributes {
+        /*! \brief The net removed */
+        bool _removed;
+        /*! \brief The net show */
+        bool _show;
+        /*! \brief The net style */
+        A3DGraphStyleData _style;
+        /*! \brief The net layer */
+        A3DUns16 _layer;
+    };
+
+    /*! \brief The net attributes of every face of a representation item, stored as compact arrays.
+     *
+     * Faces commonly share a small number of distinct styles, so each style is
+     * stored once in \c _styles and referenced by index. Styles are considered
+     * identical if all their members are equal. Padding bytes are ignored.
+     * \sa RepresentationItemInstance::getFaceNetAttributes
+     * \ingroup access
+     */
+    struct FaceNetAttributes {
+        /*! \brief The distinct net styles of the faces */
+        std::vector<A3DGraphStyleData> _styles;
+        /*! \brief The index into \c _styles of the net style of each face */
+        std::vector<A3DUns32> _style_indices;
+        /*! \brief The net removed of each face */
+        std::vector<bool> _removed;
+        /*! \brief The net show of each face */
+        std::vector<bool> _show;
+        /*! \brief The net layer of each face */
+        std::vector<A3DUns16> _layers;
+
+        /*! \brief The number of faces.
+         */
+        size_t size( void ) const {
+            return _style_indices.size();
+        }
+
+        /*! \brief Gets the net style of a face.
+         */
+        A3DGraphStyleData const &style( A3DUns32 const face_idx ) const {
+            return _styles[_style_indices[face_idx]];
+        }
+    };
+
+    /*! \brief Computes cascaded attributes for many instance paths, pushing
+     * the attributes of each distinct path prefix exactly once.
+     *
+     * Each Instance computes its cascaded attributes independently, creating and
+     * pushing an \c A3DMiscCascadedAttributes for every entity with graphics in its
+     * path. Sibling instances therefore repeat the work for their common prefix. The
+     * cache instead organizes the cascaded attributes as a trie on path prefixes, so
+     * the net attributes of every instance found by a traversal are obtained with a
+     * single push per unique prefix.
+     * \code
+     * ts3d::CascadedAttributesCache cache;
+     * for( auto const &ri_path : ts3d::leafInstances( model_file, kA3DTypeRiRepresentationItem ) ) {
+     *     if( cache.getNetShow( ri_path ) && !cache.getNetRemoved( ri_path ) ) {
+     *         ...
+     *     }
+     * }
+     * \endcode
+     * All \c A3DMiscCascadedAttributes created by the cache are deleted when it is
+     * cleared or destroyed. The cache is not thread safe.
+     * \ingroup access
+     */
+    class CascadedAttributesCache {
+    public:
+        /*! \brief Constructs an empty cache.
+         */
+        CascadedAttributesCache( void ) {
+        }
+
+        /*! \brief Deletes all cascaded attributes created by the cache.
+         */
+        ~CascadedAttributesCache( void ) {
+            clear();
+        }
+
+        CascadedAttributesCache( CascadedAttributesCache const & ) = delete;
+        CascadedAttributesCache &operator=( CascadedAttributesCache const & ) = delete;
+
+        /*! \brief Gets the cascaded attributes of \c instance_path. The result is
+         * owned by the cache and remains valid until the cache is cleared or destroyed.
+         */
+        A3DMiscCascadedAttributes *getCascadedAttributes( InstancePath const &instance_path ) {
+            return _attribs[getAttributesIndex( instance_path )];
+        }
+
+        /*! \brief Gets the net attributes of \c instance_path.
+         */
+        NetAttributes getNetAttributes( InstancePath const &instance_path ) {
+            return _net_attribs[getAttributesIndex( instance_path )];
+        }
+
+        /*! \brief Gets the net removed of \c instance_path. \sa Instance::getNetRemoved
+         */
+        bool getNetRemoved( InstancePath const &instance_path ) {
+            return _net_attribs[getAttributesIndex( instance_path )]._removed;
+        }
+
+        /*! \brief Gets the net show of \c instance_path. \sa Instance::getNetShow
+         */
+        bool getNetShow( InstancePath const &instance_path ) {
+            return _net_attribs[getAttributesIndex( instance_path )]._show;
+        }
+
+        /*! \brief Gets the net style of \c instance_path. \sa Instance::getNetStyle
+         */
+        A3DGraphStyleData getNetStyle( InstancePath const &instance_path ) {
+            return _net_attribs[getAttributesIndex( instance_path )]._style;
+        }
+
+        /*! \brief Gets the net layer of \c instance_path. \sa Instance::getNetLayer
+         */
+        A3DUns16 getNetLayer( InstancePath const &instance_path ) {
+            return _net_attribs[getAttributesIndex( instance_path )]._layer;
+        }
+
+        /*! \brief The number of cascaded attributes created by the cache.
+         */
+        size_t size( void ) const {
+            return _attribs.size();
+        }
+
+        /*! \brief Deletes all cascaded attributes created by the cache.
+         */
+        void clear( void ) {
+            ApiLock const lock;
+            for( auto attrib : _attribs ) {
+                A3DMiscCascadedAttributesDelete( attrib );
+            }
+            _attribs.clear();
+            _net_attribs.clear();
+            _prefix_attribs.clear();
+            _interner.clear();
+        }
+
+    private:
+        size_t getAttributesIndex( InstancePath const &instance_path ) {
+            if( _attribs.empty() ) {
+                // The attributes of the empty path, from which all others cascade
+                create( nullptr, nullptr );
+            }
+            if( instance_path.empty() ) {
+                return 0u;
+            }
+            auto const handle = _interner.intern( instance_path );
+            ApiLock const lock;
+            for( auto idx = _prefix_attribs.size(); idx < _interner.size(); ++idx ) {
+                // Prefixes are interned before the paths that extend them, so
+                // the attributes of each parent are already available
+                auto const prefix = static_cast<InstancePathHandle>( idx );
+                auto const parent = _interner.parent( prefix );
+                auto const father_idx = PathInterner::invalidHandle() == parent ? 0u : _prefix_attribs[parent];
+                auto const ntt = _interner.leaf( prefix );
+                if( A3DEntityIsBaseWithGraphicsType( ntt ) ) {
+                    _prefix_attribs.push_back( create( ntt, _attribs[father_idx] ) );
+                } else {
+                    _prefix_attribs.push_back( father_idx );
+                }
+            }
+            return _prefix_attribs[handle];
+        }
+
+        size_t create( A3DEntity *ntt, A3DMiscCascadedAttributes *father ) {
+            ApiLock const lock;
+            A3DMiscCascadedAttributes *attrib = nullptr;
+            CheckResult( A3DMiscCascadedAttributesCreate( &attrib ) );
+            if( nullptr != ntt ) {
+                CheckResult( A3DMiscCascadedAttributesPush( attrib, ntt, father ) );
+            }
+            _attribs.push_back( attrib );
+
+            A3DMiscCascadedAttributesWrapper d( attrib );
+            _net_attribs.push_back( { A3D_TRUE == d->m_bRemoved, A3D_TRUE == d->m_bShow, d->m_sStyle, d->m_usLayer } );
+            return _attribs.size() - 1u;
         }
-        
-        /*! \private */
-        InstancePath _path;
-        /*! \private */
-        mutable std::vector<A3DMiscCascadedAttributes*> _cascaded_attribs;
-        /*! \private */
-        mutable A3DMiscCascadedAttributesWrapper _cascaded_attribs_data;
+
+        PathInterner _interner;
+        std::vector<size_t> _prefix_attribs;
+        std::vector<A3DMiscCascadedAttributes*> _attribs;
+        std::vector<NetAttributes> _net_attribs;
     };
 
 	/*! \brief Base class for easing access to tessellation data.
@@ -1848,282 +4807,294 @@ namespace ts3d {
         A3DTessBaseWrapper _d;
     };
 
-    /*! \brief This is a helper class used to more easily provide access to the
-     * indexed mesh data for a given face.
+    /*! \brief A corner of a triangle decoded from an \c A3DTessFaceData.
+     * \sa decodeTriangles
      * \ingroup access
      */
-    class TessFaceDataHelper {
-    public:
-        /*! \private */
-        TessFaceDataHelper( A3DTessFaceData const &d, A3DUns32 const *triangulatedIndexes, A3DUns32 const *wireIndexes ) {
-            auto sz_tri_idx = 0u;
-            auto ti_index = d.m_uiStartTriangulated;
-            if(kA3DTessFaceDataTriangle & d.m_usUsedEntitiesFlags) {
-                auto const num_tris = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto tri = 0u; tri < num_tris; tri++) {
-                    for(auto vert = 0u; vert < 3u; vert++) {
-                        _normals.push_back( triangulatedIndexes[ti_index++] );
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                    }
-                }
-            }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleFan  & d.m_usUsedEntitiesFlags) {
-                auto const num_fans = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto fan_idx = 0u; fan_idx < num_fans; ++fan_idx) {
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++];
-                    auto const root_n = triangulatedIndexes[ti_index++];
-                    auto const root_v = triangulatedIndexes[ti_index++];
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        _normals.push_back( root_n );
-                        _vertices.push_back( root_v );
-                        
-                        _normals.push_back( triangulatedIndexes[ti_index++] );
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                        
-                        _normals.push_back( triangulatedIndexes[ti_index] );
-                        _vertices.push_back( triangulatedIndexes[ti_index + 1] );
-                    }
-                    ti_index += 2;
-                }
-            }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleStripe & d.m_usUsedEntitiesFlags) {
-                auto const num_tri_stips = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto strip_idx = 0u; strip_idx < num_tri_stips; ++strip_idx) {
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++];
-                    ti_index += 2;
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        auto const prev_n = triangulatedIndexes[ti_index - 2];
-                        auto const prev_v = triangulatedIndexes[ti_index - 1];
-                        auto const current_n = triangulatedIndexes[ti_index++];
-                        auto const current_v = triangulatedIndexes[ti_index++];
-                        auto const next_n = triangulatedIndexes[ti_index];
-                        auto const next_v = triangulatedIndexes[ti_index + 1];
-                        
-                        _normals.push_back( current_n );
-                        _vertices.push_back( current_v );
-                        _normals.push_back( (vert % 2) ? next_n : prev_n );
-                        _vertices.push_back( (vert % 2) ? next_v : prev_v );
-                        _normals.push_back( (vert % 2) ? prev_n : next_n );
-                        _vertices.push_back( (vert % 2) ? prev_v : next_v );
-                    }
-                    ti_index += 2;
-                }
+    struct TessFaceCorner {
+        /*! \brief Offset of the normal in the Tess3DInstance::normals() array */
+        A3DUns32 _normal;
+        /*! \brief Pointer to the \c m_uiTextureCoordIndexesSize texture coordinate
+         * indexes of the corner, or \c nullptr if the triangle is not textured */
+        A3DUns32 const *_textures;
+        /*! \brief Offset of the point in the TessBaseInstance::coords() array */
+        A3DUns32 _vertex;
+    };
+
+    /*! \brief Gets the number of triangles described by \c d, without reading
+     * the triangulated indexes. This can be used to size the buffers passed to
+     * decodeTriangles().
+     * \ingroup access
+     */
+    static inline A3DUns32 getTriangleCount( A3DTessFaceData const &d );
+
+    /*! \brief Gets the number of textured triangles described by \c d. Texture
+     * coordinate indexes are only produced for textured triangles.
+     * \ingroup access
+     */
+    static inline A3DUns32 getTexturedTriangleCount( A3DTessFaceData const &d );
+
+    /*! \brief Decodes the triangles of a face, invoking \c triangle_cb with the
+     * three corners of each triangle.
+     *
+     * All triangle lists, fans and strips described by the face are decoded in
+     * the order they appear, so the triangles are produced in the same order as
+     * TessFaceDataHelper. No memory is allocated. Texture coordinate indexes are
+     * referenced in place in \c triangulated_indexes.
+     * \param d The face tessellation data.
+     * \param triangulated_indexes The \c m_puiTriangulatedIndexes array of the \c A3DTess3DData.
+     * \param triangle_cb A callable with the signature
+     * <tt>void( TessFaceCorner const &, TessFaceCorner const &, TessFaceCorner const & )</tt>.
+     * It may be stateful, for example a mutable lambda accumulating results.
+     * \ingroup access
+     */
+    template<typename TriangleCallback>
+    static inline void decodeTriangles( A3DTessFaceData const &d, A3DUns32 const *triangulated_indexes, TriangleCallback &&triangle_cb );
+
+    /*! \brief Decodes the triangles of a face into caller provided buffers.
+     * \param d The face tessellation data.
+     * \param triangulated_indexes The \c m_puiTriangulatedIndexes array of the \c A3DTess3DData.
+     * \param vertices Receives three point offsets per triangle. Must have room for 3 * getTriangleCount() values.
+     * \param normals Receives three normal offsets per triangle. Must have room for 3 * getTriangleCount() values.
+     * \param textures Receives the texture coordinate indexes of each corner of each textured triangle,
+     * or \c nullptr if they are not needed. Must have room for
+     * 3 * \c m_uiTextureCoordIndexesSize * getTexturedTriangleCount() values.
+     * \return The number of triangles decoded.
+     * \ingroup access
+     */
+    static inline A3DUns32 decodeTriangles( A3DTessFaceData const &d, A3DUns32 const *triangulated_indexes, A3DUns32 *vertices, A3DUns32 *normals, A3DUns32 *textures );
+}
+
+namespace {
+    // Describes how the indexes of each kind of triangulated entity are laid
+    // out. Kinds are listed in the order their data appears in a face.
+    struct TessFaceKind {
+        A3DUns16 _flag;
+        bool _is_list;
+        bool _is_strip;
+        bool _one_normal;
+        bool _textured;
+    };
+
+    static TessFaceKind const _tess_face_kinds[] = {
+        { kA3DTessFaceDataTriangle, true, false, false, false },
+        { kA3DTessFaceDataTriangleFan, false, false, false, false },
+        { kA3DTessFaceDataTriangleStripe, false, true, false, false },
+        { kA3DTessFaceDataTriangleOneNormal, true, false, true, false },
+        { kA3DTessFaceDataTriangleFanOneNormal, false, false, true, false },
+        { kA3DTessFaceDataTriangleStripeOneNormal, false, true, true, false },
+        { kA3DTessFaceDataTriangleTextured, true, false, false, true },
+        { kA3DTessFaceDataTriangleFanTextured, false, false, false, true },
+        { kA3DTessFaceDataTriangleStripeTextured, false, true, false, true },
+        { kA3DTessFaceDataTriangleOneNormalTextured, true, false, true, true },
+        { kA3DTessFaceDataTriangleFanOneNormalTextured, false, false, true, true },
+        { kA3DTessFaceDataTriangleStripeOneNormalTextured, false, true, true, true }
+    };
+
+    // Counts the triangles of the kinds selected by textured_only by walking
+    // the sizes array only
+    static inline A3DUns32 countTriangles( A3DTessFaceData const &d, bool const textured_only ) {
+        auto result = 0u;
+        auto sz_tri_idx = 0u;
+        for( auto const &kind : _tess_face_kinds ) {
+            if( !(kind._flag & d.m_usUsedEntitiesFlags) || d.m_uiSizesTriangulatedSize <= sz_tri_idx ) {
+                continue;
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleOneNormal & d.m_usUsedEntitiesFlags) {
-                auto const num_tris_1normal = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto tri = 0u; tri < num_tris_1normal; tri++) {
-                    auto n = triangulatedIndexes[ti_index++];
-                    for(auto vert = 0u; vert < 3u; vert++) {
-                        _normals.push_back( n );
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                    }
-                }
+            auto const count = d.m_puiSizesTriangulated[sz_tri_idx++];
+            auto const counted = !textured_only || kind._textured;
+            if( kind._is_list ) {
+                result += counted ? count : 0u;
+                continue;
             }
-            
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleFanOneNormal & d.m_usUsedEntitiesFlags) {
-                auto const num_fans_1normal = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto fan_idx = 0u; fan_idx < num_fans_1normal; ++fan_idx) {
-                    auto const has_vertex_normals = 0 == (d.m_puiSizesTriangulated[sz_tri_idx] & kA3DTessFaceDataNormalSingle);
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++] & kA3DTessFaceDataNormalMask;
-                    auto const root_n = triangulatedIndexes[ti_index++];
-                    auto const root_v = triangulatedIndexes[ti_index++];
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        auto const n = (has_vertex_normals ? triangulatedIndexes[ti_index++] : root_n);
-                        auto const v = triangulatedIndexes[ti_index++];
-                        
-                        auto const next_n = (has_vertex_normals ? triangulatedIndexes[ti_index] : root_n);
-                        auto const next_v = triangulatedIndexes[ti_index + (has_vertex_normals ? 1 : 0)];
-                        
-                        _normals.push_back( root_n );
-                        _vertices.push_back( root_v );
-                        _normals.push_back( n );
-                        _vertices.push_back( v );
-                        _normals.push_back( next_n );
-                        _vertices.push_back( next_v );
-                    }
-                    ti_index += (has_vertex_normals ? 2 : 1);
-                }
+            for( auto idx = 0u; idx < count; ++idx ) {
+                auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++] & (kind._one_normal ? kA3DTessFaceDataNormalMask : ~0u);
+                result += (counted && num_pts > 2u) ? num_pts - 2u : 0u;
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleStripeOneNormal & d.m_usUsedEntitiesFlags) {
-                auto const num_tri_stips = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto strip_idx = 0u; strip_idx < num_tri_stips; ++strip_idx) {
-                    auto const has_vertex_normals = 0 == (d.m_puiSizesTriangulated[sz_tri_idx] & kA3DTessFaceDataNormalSingle);
-                    auto const series_normal = triangulatedIndexes[ti_index];
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++] & kA3DTessFaceDataNormalMask;
-                    ti_index += 2;
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        auto const prev_n = (has_vertex_normals ? triangulatedIndexes[ti_index - 2] : series_normal);
-                        auto const prev_v = triangulatedIndexes[ti_index - 1];
-                        
-                        auto const current_n = (has_vertex_normals ? triangulatedIndexes[ti_index++] : series_normal);
-                        auto const current_v = triangulatedIndexes[ti_index++];
-                        
-                        auto const next_n = (has_vertex_normals ? triangulatedIndexes[ti_index] : series_normal);
-                        auto const next_v = triangulatedIndexes[ti_index + (has_vertex_normals ? 1 : 0)];
-                        
-                        _normals.push_back( current_n );
-                        _vertices.push_back( current_v );
-                        _normals.push_back( (vert % 2) ? next_n : prev_n );
-                        _vertices.push_back( (vert % 2) ? next_v : prev_v );
-                        _normals.push_back( (vert % 2) ? prev_n : next_n );
-                        _vertices.push_back( (vert % 2) ? prev_v : next_v );
-                    }
-                    ti_index += (has_vertex_normals ? 2 : 1);
-                }
+        }
+        return result;
+    }
+}
+
+A3DUns32 ts3d::getTriangleCount( A3DTessFaceData const &d ) {
+    return countTriangles( d, false );
+}
+
+A3DUns32 ts3d::getTexturedTriangleCount( A3DTessFaceData const &d ) {
+    return countTriangles( d, true );
+}
+
+namespace {
+    // Decodes the triangles of one kind of triangulated entity. The layout is
+    // selected at compile time so the inner loops contain no layout branches.
+    // Each corner is stored as [normal] [textures] point, where the normal is
+    // omitted if a single normal precedes the triangle or series.
+    // The read position is returned rather than updated through a reference,
+    // since the callback's stores could otherwise alias it.
+    template<bool IsList, bool IsStrip, bool OneNormal, bool Textured, typename TriangleCallback>
+    static inline A3DUns32 const *decodeTessFaceKind( A3DUns32 const *sizes, A3DUns32 const texture_count, A3DUns32 const *ti, TriangleCallback &triangle_cb ) {
+        auto const readCorner = [texture_count, &ti]( bool const has_normal, A3DUns32 const normal ) {
+            ts3d::TessFaceCorner corner;
+            corner._normal = has_normal ? *ti++ : normal;
+            corner._textures = Textured ? ti : nullptr;
+            ti += Textured ? texture_count : 0u;
+            corner._vertex = *ti++;
+            return corner;
+        };
+
+        auto const count = *sizes++;
+        if( IsList ) {
+            for( auto tri = 0u; tri < count; ++tri ) {
+                auto const normal = OneNormal ? *ti++ : 0u;
+                auto const c0 = readCorner( !OneNormal, normal );
+                auto const c1 = readCorner( !OneNormal, normal );
+                auto const c2 = readCorner( !OneNormal, normal );
+                triangle_cb( c0, c1, c2 );
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleTextured & d.m_usUsedEntitiesFlags) {
-                auto const num_tris = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto tri_idx = 0u; tri_idx < num_tris; tri_idx++) {
-                    for(auto vert_idx = 0u; vert_idx < 3u; vert_idx++) {
-                        _normals.push_back( triangulatedIndexes[ti_index++] );
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            _texture.push_back( triangulatedIndexes[ti_index++] );
-                        }
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                    }
-                }
+            return ti;
+        }
+
+        for( auto series_idx = 0u; series_idx < count; ++series_idx ) {
+            auto const num_pts_with_flags = *sizes++;
+            auto const single_normal = OneNormal && 0u != (num_pts_with_flags & kA3DTessFaceDataNormalSingle);
+            auto const num_pts = OneNormal ? num_pts_with_flags & kA3DTessFaceDataNormalMask : num_pts_with_flags;
+            auto const series_normal = single_normal ? *ti++ : 0u;
+            if( 0u == num_pts ) {
+                continue;
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleFanTextured & d.m_usUsedEntitiesFlags) {
-                auto const num_fans_textured = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto fan_idx = 0u; fan_idx < num_fans_textured; ++fan_idx) {
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++];
-                    auto const n = triangulatedIndexes[ti_index++];
-                    std::vector<A3DUns32> t;
-                    for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                        t.push_back( triangulatedIndexes[ti_index++] );
-                    }
-                    auto const v = triangulatedIndexes[ti_index++];
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        _normals.push_back( n );
-                        _texture.insert( _texture.end(), t.begin(), t.end() );
-                        _vertices.push_back( v );
-                        
-                        _normals.push_back( triangulatedIndexes[ti_index++] );
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            _texture.push_back( triangulatedIndexes[ti_index++] );
-                        }
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                        
-                        _normals.push_back( triangulatedIndexes[ti_index++] );
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            _texture.push_back( triangulatedIndexes[ti_index++] );
-                        }
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                    }
-                }
+
+            // Only the first (or previous) and last corners are needed to form each triangle
+            auto first = readCorner( !single_normal, series_normal );
+            if( 1u == num_pts ) {
+                continue;
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleStripeTextured  & d.m_usUsedEntitiesFlags) {
-                auto const num_tri_stips = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto strip_idx = 0u; strip_idx < num_tri_stips; ++strip_idx) {
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++];
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        auto const prev_n = triangulatedIndexes[ti_index - (2 + d.m_uiTextureCoordIndexesSize)];
-                        std::vector<A3DUns32> prev_t;
-                        for( auto i = ti_index - (1 + d.m_uiTextureCoordIndexesSize); i < ti_index - 1; ++i ) {
-                            prev_t.push_back( triangulatedIndexes[i] );
-                        }
-                        auto const prev_v = triangulatedIndexes[ti_index - 1];
-                        
-                        auto const current_n = triangulatedIndexes[ti_index++];
-                        std::vector<A3DUns32> current_t;
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            current_t.push_back( triangulatedIndexes[ti_index++] );
-                        }
-                        auto const current_v = triangulatedIndexes[ti_index++];
-                        
-                        auto const next_n = triangulatedIndexes[ti_index];
-                        std::vector<A3DUns32> next_t;
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            next_t.push_back( triangulatedIndexes[ ti_index + i + 1] );
-                        }
-                        auto const next_v = triangulatedIndexes[ti_index + 1 + d.m_uiTextureCoordIndexesSize];
-                        
-                        _normals.push_back( current_n );
-                        _texture.insert( _texture.end(), current_t.begin(), current_t.end() );
-                        _vertices.push_back( current_v );
-                        
-                        _normals.push_back( (vert % 2) ? next_n : prev_n );
-                        _texture.insert( _texture.end(), (vert % 2) ? next_t.begin() : prev_t.begin(), (vert % 2) ? next_t.end() : prev_t.end() );
-                        _vertices.push_back( (vert % 2) ? next_v : prev_v );
-                        
-                        _normals.push_back( (vert % 2) ? prev_n : next_n );
-                        _texture.insert( _texture.end(), (vert % 2) ? prev_t.begin() : next_t.begin(), (vert % 2) ? prev_t.end() : next_t.end() );
-                        _vertices.push_back( (vert % 2) ? prev_v : next_v );
-                    }
+            auto last = readCorner( !single_normal, series_normal );
+            for( auto vert = 1u; vert < num_pts - 1u; ++vert ) {
+                // Fans emit (first, last, next), strips alternate between
+                // (last, next, first) and (last, first, next) to keep the winding
+                auto const next = readCorner( !single_normal, series_normal );
+                auto const odd = IsStrip && 0u != vert % 2;
+                triangle_cb( IsStrip ? last : first, odd ? next : (IsStrip ? first : last), odd ? first : next );
+                if( IsStrip ) {
+                    first = last;
                 }
+                last = next;
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleOneNormalTextured  & d.m_usUsedEntitiesFlags) {
-                auto const has_vertex_normals = 0 == (d.m_puiSizesTriangulated[sz_tri_idx] & kA3DTessFaceDataNormalSingle);
-                auto const series_normal = triangulatedIndexes[ti_index];
-                auto const num_tris_1normal_textured = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto tri = 0u; tri < num_tris_1normal_textured; tri++) {
-                    for(auto vert = 0u; vert < 3u; vert++) {
-                        _normals.push_back( has_vertex_normals ? triangulatedIndexes[ti_index++] : series_normal );
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            _texture.push_back( triangulatedIndexes[ti_index++] );
-                        }
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                    }
-                }
+        }
+        return ti;
+    }
+}
+
+namespace {
+    template<typename TriangleCallback>
+    static inline void decodeTessFace( A3DTessFaceData const &d, A3DUns32 const *triangulated_indexes, TriangleCallback &triangle_cb ) {
+        auto const texture_count = d.m_uiTextureCoordIndexesSize;
+        auto ti = triangulated_indexes + d.m_uiStartTriangulated;
+        auto sz_tri_idx = 0u;
+        for( auto const &kind : _tess_face_kinds ) {
+            if( !(kind._flag & d.m_usUsedEntitiesFlags) || d.m_uiSizesTriangulatedSize <= sz_tri_idx ) {
+                continue;
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleFanOneNormalTextured & d.m_usUsedEntitiesFlags) {
-                auto const num_fans_textured = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto fan_idx = 0u; fan_idx < num_fans_textured; ++fan_idx) {
-                    auto const root_n = triangulatedIndexes[ti_index++];
-                    std::vector<A3DUns32> root_t;
-                    for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                        root_t.push_back( triangulatedIndexes[ti_index++] );
-                    }
-                    auto const root_v = triangulatedIndexes[ti_index++];
-                    auto const has_vertex_normals = 0 == (d.m_puiSizesTriangulated[sz_tri_idx] & kA3DTessFaceDataNormalSingle);
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++] & kA3DTessFaceDataNormalMask;
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        _normals.push_back( root_n );
-                        _texture.insert( _texture.end(), root_t.begin(), root_t.end() );
-                        _vertices.push_back( root_v );
-                        
-                        _normals.push_back( has_vertex_normals ? triangulatedIndexes[ti_index++] : root_n );
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            _texture.push_back( triangulatedIndexes[ti_index++] );
-                        }
-                        _vertices.push_back( triangulatedIndexes[ti_index++] );
-                        
-                        _normals.push_back( has_vertex_normals ? triangulatedIndexes[ti_index] : root_n );
-                        for( auto i = 0u; i < d.m_uiTextureCoordIndexesSize; ++i ) {
-                            _texture.push_back( triangulatedIndexes[ti_index + i + 1] );
-                        }
-                        _vertices.push_back( triangulatedIndexes[ti_index + 1 + (has_vertex_normals ? d.m_uiTextureCoordIndexesSize : 0)] );
-                    }
-                }
+            auto const sizes = d.m_puiSizesTriangulated + sz_tri_idx;
+            sz_tri_idx += kind._is_list ? 1u : 1u + sizes[0];
+            switch( kind._flag ) {
+                case kA3DTessFaceDataTriangle:
+                    ti = decodeTessFaceKind<true, false, false, false>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleFan:
+                    ti = decodeTessFaceKind<false, false, false, false>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleStripe:
+                    ti = decodeTessFaceKind<false, true, false, false>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleOneNormal:
+                    ti = decodeTessFaceKind<true, false, true, false>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleFanOneNormal:
+                    ti = decodeTessFaceKind<false, false, true, false>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleStripeOneNormal:
+                    ti = decodeTessFaceKind<false, true, true, false>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleTextured:
+                    ti = decodeTessFaceKind<true, false, false, true>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleFanTextured:
+                    ti = decodeTessFaceKind<false, false, false, true>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleStripeTextured:
+                    ti = decodeTessFaceKind<false, true, false, true>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleOneNormalTextured:
+                    ti = decodeTessFaceKind<true, false, true, true>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleFanOneNormalTextured:
+                    ti = decodeTessFaceKind<false, false, true, true>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                case kA3DTessFaceDataTriangleStripeOneNormalTextured:
+                    ti = decodeTessFaceKind<false, true, true, true>( sizes, texture_count, ti, triangle_cb );
+                    break;
+                default:
+                    break;
             }
-            if(d.m_uiSizesTriangulatedSize > sz_tri_idx && kA3DTessFaceDataTriangleStripeOneNormalTextured & d.m_usUsedEntitiesFlags) {
-                auto const num_tri_stips = d.m_puiSizesTriangulated[sz_tri_idx++];
-                for(auto strip_idx = 0u; strip_idx < num_tri_stips; ++strip_idx) {
-                    auto const has_vertex_normals = 0 == (d.m_puiSizesTriangulated[sz_tri_idx] & kA3DTessFaceDataNormalSingle);
-                    auto const num_pts = d.m_puiSizesTriangulated[sz_tri_idx++] & kA3DTessFaceDataNormalMask;
-                    auto const series_normal = triangulatedIndexes[ti_index];
-                    ti_index += 2 + d.m_uiStyleIndexesSize;
-                    for(auto vert = 1u; vert < num_pts - 1u; vert++) {
-                        auto const prev_n = has_vertex_normals ? triangulatedIndexes[ti_index - (2 + d.m_uiTextureCoordIndexesSize)] : series_normal;
-                        auto const prev_v = triangulatedIndexes[ti_index - 1];
-                        
-                        
-                        auto const current_n = has_vertex_normals ? triangulatedIndexes[ti_index++] : series_normal;
-                        ti_index += d.m_uiTextureCoordIndexesSize;
-                        auto const current_v = triangulatedIndexes[ti_index++];
-                        
-                        auto const next_n = has_vertex_normals ? triangulatedIndexes[ti_index] : series_normal;
-                        auto const next_v = triangulatedIndexes[ti_index + 1 + (has_vertex_normals ? d.m_uiTextureCoordIndexesSize : 0)];
-                        
-                        _normals.push_back( current_n );
-                        _vertices.push_back( current_v );
-                        _normals.push_back( (vert % 2) ? next_n : prev_n );
-                        _vertices.push_back( (vert % 2) ? next_v : prev_v );
-                        _normals.push_back( (vert % 2) ? prev_n : next_n );
-                        _vertices.push_back( (vert % 2) ? prev_v : next_v );
-                    }
-                }
+        }
+    }
+}
+
+template<typename TriangleCallback>
+void ts3d::decodeTriangles( A3DTessFaceData const &d, A3DUns32 const *triangulated_indexes, TriangleCallback &&triangle_cb ) {
+    decodeTessFace( d, triangulated_indexes, triangle_cb );
+}
+
+namespace {
+    // Writes decoded triangles to the buffers of the corresponding
+    // decodeTriangles() overload. A single corner count is the only state
+    // updated per triangle.
+    struct TessFaceBufferWriter {
+        void operator()( ts3d::TessFaceCorner const &c0, ts3d::TessFaceCorner const &c1, ts3d::TessFaceCorner const &c2 ) {
+            write( c0 );
+            write( c1 );
+            write( c2 );
+        }
+
+        void write( ts3d::TessFaceCorner const &corner ) {
+            _vertices[_corner_count] = corner._vertex;
+            _normals[_corner_count] = corner._normal;
+            ++_corner_count;
+            if( _textures && corner._textures ) {
+                std::copy( corner._textures, corner._textures + _texture_count, _textures + _texture_idx );
+                _texture_idx += _texture_count;
             }
+        }
+
+        A3DUns32 *_vertices;
+        A3DUns32 *_normals;
+        A3DUns32 *_textures;
+        A3DUns32 _texture_count;
+        size_t _corner_count;
+        size_t _texture_idx;
+    };
+}
+
+A3DUns32 ts3d::decodeTriangles( A3DTessFaceData const &d, A3DUns32 const *triangulated_indexes, A3DUns32 *vertices, A3DUns32 *normals, A3DUns32 *textures ) {
+    TessFaceBufferWriter writer = { vertices, normals, textures, d.m_uiTextureCoordIndexesSize, 0u, 0u };
+    decodeTessFace( d, triangulated_indexes, writer );
+    return static_cast<A3DUns32>( writer._corner_count / 3u );
+}
+
+namespace ts3d {
+    /*! \brief This is a helper class used to more easily provide access to the
+     * indexed mesh data for a given face.
+     * \ingroup access
+     */
+    class TessFaceDataHelper {
+    public:
+        /*! \private */
+        TessFaceDataHelper( A3DTessFaceData const &d, A3DUns32 const *triangulatedIndexes, A3DUns32 const *wireIndexes ) {
+            auto const triangle_count = getTriangleCount( d );
+            _vertices.resize( 3u * triangle_count );
+            _normals.resize( 3u * triangle_count );
+            _texture.resize( 3u * d.m_uiTextureCoordIndexesSize * getTexturedTriangleCount( d ) );
+            decodeTriangles( d, triangulatedIndexes, _vertices.data(), _normals.data(), _texture.data() );
             
             auto wi_index = d.m_uiStartWire;
             TessLoop current_loop;
@@ -2134,9 +5105,8 @@ namespace ts3d {
                 auto const is_hidden = nverts_with_flags & kA3DTessFaceDataWireIsNotDrawn;
                 TessEdge current_edge;
                 current_edge._visible = !is_hidden;
-                for(auto vidx = 0u; vidx < nvertices; ++vidx ) {
-                    current_edge._vertices.push_back( wireIndexes[wi_index++] );
-                }
+                current_edge._vertices.assign( wireIndexes + wi_index, wireIndexes + wi_index + nvertices );
+                wi_index += nvertices;
                 current_loop._edges.push_back( current_edge );
                 
                 if(is_closing) {
@@ -2228,6 +5198,70 @@ namespace ts3d {
         std::vector<TessLoop> _loops;
     };
 
+    /*! \brief The index mesh of all faces of a Tess3DInstance, stored in
+     * contiguous arrays.
+     *
+     * Triangles are stored face after face, in face order. The triangles of
+     * face \c i are <tt>[_face_triangles[i].first, _face_triangles[i].second)</tt>,
+     * and the corners of triangle \c t are at offsets <tt>3 * t</tt> to
+     * <tt>3 * t + 2</tt> of _vertices and _normals.
+     * \sa Tess3DInstance::getIndexMesh
+     * \ingroup access
+     */
+    struct TessBodyMesh {
+        /*! \brief Offsets of the points in the TessBaseInstance::coords() array, three per triangle */
+        std::vector<A3DUns32> _vertices;
+        /*! \brief Offsets of the normals in the Tess3DInstance::normals() array, three per triangle */
+        std::vector<A3DUns32> _normals;
+        /*! \brief Texture coordinate indexes of the corners of textured triangles */
+        std::vector<A3DUns32> _textures;
+        /*! \brief Range [first, second) of triangles belonging to each face */
+        std::vector<std::pair<A3DUns32, A3DUns32>> _face_triangles;
+        /*! \brief Range [first, second) of _textures belonging to each face */
+        std::vector<std::pair<A3DUns32, A3DUns32>> _face_textures;
+        /*! \brief Index of the face each triangle belongs to */
+        std::vector<A3DUns32> _face_ids;
+
+        /*! \brief Gets the total number of triangles */
+        size_t triangleCount( void ) const {
+            return _face_ids.size();
+        }
+    };
+
+    /*! \brief A triangle mesh with a single index per vertex, where each
+     * vertex interleaves its position, normal and optionally texture
+     * coordinates. This is the layout expected by most GPU APIs.
+     * \sa Tess3DInstance::getInterleavedMesh
+     * \ingroup access
+     */
+    struct InterleavedMesh {
+        /*! \brief Number of values per vertex. 6 for position and normal,
+         * or 8 if texture coordinates follow them. */
+        A3DUns32 _stride;
+        /*! \brief Vertex values, _stride per vertex */
+        std::vector<double> _vertices;
+        /*! \brief Vertex indexes, three per triangle */
+        std::vector<A3DUns32> _indices;
+        /*! \brief Range [first, second) of triangles belonging to each face */
+        std::vector<std::pair<A3DUns32, A3DUns32>> _face_triangles;
+
+        /*! \brief Gets the number of vertices */
+        size_t vertexCount( void ) const {
+            return _stride ? _vertices.size() / _stride : 0u;
+        }
+    };
+
+    /*! \brief Controls which triangle corners are merged into a single vertex
+     * \sa Tess3DInstance::getInterleavedMesh
+     * \ingroup access
+     */
+    enum class WeldMode {
+        /*! \brief Corners sharing the same point, normal and texture coordinates are merged, whichever face they belong to */
+        AcrossFaces,
+        /*! \brief Corners are only merged within a face, so faces share no vertices */
+        PerFace
+    };
+
     /*! \brief Encapsulates the functionality desired to easily retrieve
      * normal and texture coordinates for a tessellation.
      * \ingroup access
@@ -2257,66 +5291,361 @@ namespace ts3d {
             return _d->m_uiNormalSize;
         }
         
-        /*! \brief Obtains a pointer to an array of texture coordinates.
-         *  The length of this array is determined by texCoordsSize()
+        /*! \brief Obtains a pointer to an array of texture coordinates.
+         *  The length of this array is determined by texCoordsSize()
+         */
+        double const *texCoords( void ) const {
+            return _d->m_pdTextureCoords;
+        }
+
+        /*! \brief Provides the length of the texCoords array.
+         */
+        A3DUns32 texCoordsSize( void ) const {
+            return _d->m_uiTextureCoordSize;
+        }
+        
+        /*! \brief Provides the total number of faces with available
+         *  tessellation data. \sa getIndexMeshForFace
+         */
+        A3DUns32 faceSize( void ) const {
+            return _d->m_uiFaceTessSize;
+        }
+
+        /*! \brief Gets an object that wraps the tessellation data of
+         *  a given face.
+         * \param face_idx Index of the face to obtain the access helper for.
+         *  Valid index values must fall in the interval [0, faceSize()).
+         */
+        TessFaceDataHelper getIndexMeshForFace( A3DUns32 const &face_idx ) const {
+            if( face_idx >= _d->m_uiFaceTessSize ) {
+                throw std::out_of_range( "Index of face requested for index mesh is out of range." );
+            }
+            return TessFaceDataHelper( _d->m_psFaceTessData[face_idx], _d->m_puiTriangulatedIndexes, _d->m_puiWireIndexes );
+        }
+
+        /*! \brief Gets the index mesh of all faces at once.
+         *
+         * The triangles are the same as those of getIndexMeshForFace, for
+         * each face in turn. The face sizes are counted first so each array
+         * is allocated exactly once, which is considerably cheaper than
+         * obtaining a TessFaceDataHelper for each face. Edge loops are not
+         * included.
+         */
+        TessBodyMesh getIndexMesh( void ) const {
+            auto result = allocateIndexMesh();
+            decodeIndexMesh( result, 0u, _d->m_uiFaceTessSize );
+            return result;
+        }
+
+        /*! \brief Parallel variant of getIndexMesh(), for bodies with many faces.
+         *
+         * The output is identical to that of getIndexMesh(). Faces are decoded
+         * concurrently, directly into their place in the preallocated arrays.
+         * \param thread_count The number of threads to use. If zero, \c std::thread::hardware_concurrency() is used.
+         * \param triangles_per_chunk The approximate number of triangles decoded by each task. Faces are
+         * never split, and a value of zero is treated as one.
+         */
+        TessBodyMesh getIndexMeshParallel( unsigned int const thread_count = 0u, size_t const triangles_per_chunk = 4096u ) const {
+            auto result = allocateIndexMesh();
+            auto const n_faces = _d->m_uiFaceTessSize;
+            auto const n_triangles = result.triangleCount();
+
+            // Faces are scheduled in chunks of about triangles_per_chunk triangles, so
+            // the cost of scheduling is not paid by each of many small faces
+            auto const n_chunks = std::min<size_t>( n_faces, std::max<size_t>( 1u, n_triangles / std::max<size_t>( 1u, triangles_per_chunk ) ) );
+            auto const chunkBegin = [&result, n_faces, n_triangles, n_chunks]( size_t const chunk_idx ) {
+                if( chunk_idx >= n_chunks ) {
+                    return n_faces;
+                }
+                auto const first_triangle = static_cast<A3DUns32>( chunk_idx * n_triangles / n_chunks );
+                auto const it = std::lower_bound( result._face_triangles.begin(), result._face_triangles.end(), first_triangle, []( std::pair<A3DUns32, A3DUns32> const &range, A3DUns32 const triangle ) {
+                    return range.first < triangle;
+                });
+                return 0u == chunk_idx ? 0u : static_cast<A3DUns32>( it - result._face_triangles.begin() );
+            };
+            parallelFor( n_chunks, thread_count, [this, &result, &chunkBegin]( size_t const chunk_idx ) {
+                decodeIndexMesh( result, chunkBegin( chunk_idx ), chunkBegin( chunk_idx + 1u ) );
+            });
+            return result;
+        }
+
+        /*! \brief Gets the tessellation as an indexed mesh of interleaved vertices.
+         *
+         * Exchange indexes points and normals separately. This combines
+         * each distinct (point, normal, texture) index tuple into a single
+         * vertex, so the mesh can be drawn with one index buffer.
+         * \param weld_mode Whether vertices may be shared between faces.
+         * \param with_texture_coords If \c true and the tessellation is textured,
+         * the first texture coordinate pair of each corner is appended to each
+         * vertex. Corners of untextured triangles receive (0, 0).
+         */
+        inline InterleavedMesh getInterleavedMesh( WeldMode const weld_mode = WeldMode::AcrossFaces, bool const with_texture_coords = false ) const;
+        
+    private:
+        // Computes the face ranges of the mesh with a prefix sum over the face
+        // sizes, and sizes the index arrays accordingly
+        TessBodyMesh allocateIndexMesh( void ) const {
+            TessBodyMesh result;
+            auto const n_faces = _d->m_uiFaceTessSize;
+            result._face_triangles.resize( n_faces );
+            result._face_textures.resize( n_faces );
+
+            auto n_triangles = 0u;
+            auto n_textures = 0u;
+            for( auto face_idx = 0u; face_idx < n_faces; ++face_idx ) {
+                auto const &face = _d->m_psFaceTessData[face_idx];
+                result._face_triangles[face_idx].first = n_triangles;
+                n_triangles += getTriangleCount( face );
+                result._face_triangles[face_idx].second = n_triangles;
+                result._face_textures[face_idx].first = n_textures;
+                n_textures += 3u * face.m_uiTextureCoordIndexesSize * getTexturedTriangleCount( face );
+                result._face_textures[face_idx].second = n_textures;
+            }
+
+            result._vertices.resize( 3u * n_triangles );
+            result._normals.resize( 3u * n_triangles );
+            result._textures.resize( n_textures );
+            result._face_ids.resize( n_triangles );
+            return result;
+        }
+
+        // Decodes the faces in [face_begin, face_end) into a mesh obtained
+        // from allocateIndexMesh(). Faces only write to their own ranges.
+        void decodeIndexMesh( TessBodyMesh &mesh, A3DUns32 const face_begin, A3DUns32 const face_end ) const {
+            for( auto face_idx = face_begin; face_idx < face_end; ++face_idx ) {
+                auto const &triangles = mesh._face_triangles[face_idx];
+                auto const &textures = mesh._face_textures[face_idx];
+                decodeTriangles( _d->m_psFaceTessData[face_idx], _d->m_puiTriangulatedIndexes,
+                                 mesh._vertices.data() + 3u * triangles.first,
+                                 mesh._normals.data() + 3u * triangles.first,
+                                 textures.first == textures.second ? nullptr : mesh._textures.data() + textures.first );
+                std::fill( mesh._face_ids.begin() + triangles.first, mesh._face_ids.begin() + triangles.second, face_idx );
+            }
+        }
+
+        A3DTess3DWrapper _d;
+    };
+
+}
+
+namespace {
+    // Index tuple identifying a welded vertex
+    struct WeldKey {
+        A3DUns32 _face;
+        A3DUns32 _point;
+        A3DUns32 _normal;
+        A3DUns32 _texture;
+    };
+
+    static A3DUns32 const EmptyWeldSlot = ~0u;
+
+    // Maps index tuples to dense vertex indexes, using open addressing with
+    // linear probing. The slot array holds vertex indexes into _keys and is
+    // sized so that it is never more than half full.
+    class VertexWelder {
+    public:
+        explicit VertexWelder( size_t const max_vertices ) {
+            auto capacity = size_t( 16u );
+            while( capacity < 2u * max_vertices ) {
+                capacity *= 2u;
+            }
+            _slots.assign( capacity, EmptyWeldSlot );
+            _keys.reserve( max_vertices );
+        }
+
+        // Returns the vertex index of key, adding a vertex if it is new
+        A3DUns32 insert( WeldKey const &key ) {
+            auto const mask = _slots.size() - 1u;
+            for( auto slot = hash( key ) & mask; ; slot = (slot + 1u) & mask ) {
+                auto &vertex_idx = _slots[slot];
+                if( EmptyWeldSlot == vertex_idx ) {
+                    vertex_idx = static_cast<A3DUns32>( _keys.size() );
+                    _keys.push_back( key );
+                    return vertex_idx;
+                }
+                auto const &other = _keys[vertex_idx];
+                if( other._point == key._point && other._normal == key._normal && other._texture == key._texture && other._face == key._face ) {
+                    return vertex_idx;
+                }
+            }
+        }
+
+        std::vector<WeldKey> const &keys( void ) const {
+            return _keys;
+        }
+
+    private:
+        // Index values are offsets into coordinate arrays and so are mostly
+        // multiples of 3. The 64 bit finalizer of MurmurHash3 spreads them
+        // over the low bits used to pick a slot.
+        static size_t hash( WeldKey const &key ) {
+            auto h = (static_cast<A3DUns64>( key._point ) | (static_cast<A3DUns64>( key._normal ) << 32)) * 0x9e3779b97f4a7c15ull;
+            h ^= (static_cast<A3DUns64>( key._texture ) | (static_cast<A3DUns64>( key._face ) << 32)) * 0xc2b2ae3d27d4eb4full;
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+            return static_cast<size_t>( h );
+        }
+
+        std::vector<A3DUns32> _slots;
+        std::vector<WeldKey> _keys;
+    };
+
+    // Triangle callback that welds the corners of each triangle and writes
+    // the resulting vertex indexes
+    struct TriangleWelder {
+        void operator()( ts3d::TessFaceCorner const &c0, ts3d::TessFaceCorner const &c1, ts3d::TessFaceCorner const &c2 ) {
+            _indices[0] = weld( c0 );
+            _indices[1] = weld( c1 );
+            _indices[2] = weld( c2 );
+            _indices += 3;
+        }
+
+        A3DUns32 weld( ts3d::TessFaceCorner const &corner ) {
+            WeldKey const key = { _face_key, corner._vertex, corner._normal, _textured && corner._textures ? corner._textures[0] : EmptyWeldSlot };
+            return _welder.insert( key );
+        }
+
+        VertexWelder &_welder;
+        A3DUns32 *_indices;
+        A3DUns32 _face_key;
+        bool _textured;
+    };
+}
+
+ts3d::InterleavedMesh ts3d::Tess3DInstance::getInterleavedMesh( WeldMode const weld_mode, bool const with_texture_coords ) const {
+    InterleavedMesh result;
+    auto const n_faces = _d->m_uiFaceTessSize;
+    result._face_triangles.resize( n_faces );
+    auto n_triangles = 0u;
+    auto is_textured = false;
+    for( auto face_idx = 0u; face_idx < n_faces; ++face_idx ) {
+        auto const &face = _d->m_psFaceTessData[face_idx];
+        result._face_triangles[face_idx].first = n_triangles;
+        n_triangles += getTriangleCount( face );
+        result._face_triangles[face_idx].second = n_triangles;
+        is_textured = is_textured || (0u != face.m_uiTextureCoordIndexesSize && 0u != getTexturedTriangleCount( face ));
+    }
+    auto const textured = with_texture_coords && is_textured && nullptr != _d->m_pdTextureCoords;
+    result._stride = textured ? 8u : 6u;
+    result._indices.resize( 3u * n_triangles );
+
+    // Assign vertex indexes first, so the vertex buffer can be allocated
+    // once at its final size
+    VertexWelder welder( result._indices.size() );
+    TriangleWelder triangle_welder = { welder, result._indices.data(), 0u, textured };
+    for( auto face_idx = 0u; face_idx < n_faces; ++face_idx ) {
+        triangle_welder._face_key = WeldMode::PerFace == weld_mode ? face_idx : 0u;
+        decodeTessFace( _d->m_psFaceTessData[face_idx], _d->m_puiTriangulatedIndexes, triangle_welder );
+    }
+
+    auto const points = coords();
+    auto const normals = _d->m_pdNormals;
+    auto const texture_coords = _d->m_pdTextureCoords;
+    result._vertices.resize( result._stride * welder.keys().size() );
+    auto vertex = result._vertices.data();
+    for( auto const &key : welder.keys() ) {
+        vertex = std::copy( points + key._point, points + key._point + 3u, vertex );
+        vertex = std::copy( normals + key._normal, normals + key._normal + 3u, vertex );
+        if( textured ) {
+            auto const has_uv = EmptyWeldSlot != key._texture;
+            *vertex++ = has_uv ? texture_coords[key._texture] : 0.;
+            *vertex++ = has_uv ? texture_coords[key._texture + 1u] : 0.;
+        }
+    }
+    return result;
+}
+
+namespace ts3d {
+    /*! \brief Provides easy access to wire tessellation data.
+     *
+     * The wires are stored as flat polylines. The point offsets of all wires
+     * are in a single array, vertices(), and wire \c i occupies the range
+     * <tt>[offsets()[i], offsets()[i + 1])</tt> of it. The closed and connected
+     * flags of the wires are held in bitsets.
+     *  \ingroup access
+     */
+    class Tess3DWireInstance : public TessBaseInstance {
+    public:
+        /*! \brief Throws if leaf type is not kA3DTypeTess3DWire
+         */
+        Tess3DWireInstance( InstancePath const &path )
+        : TessBaseInstance( path ) {
+            if( kA3DTypeTess3DWire != leafType() ) {
+                throw std::invalid_argument( "Expected A3DTess3DWire leaf node type." );
+            }
+            _d.reset( leaf() );
+
+            auto const n_wires = _d->m_uiSizesWiresSize;
+            _offsets.resize( n_wires + 1u );
+            _closed.resize( n_wires );
+            _connected_to_previous.resize( n_wires );
+            auto offset = 0u;
+            for( auto wire_idx = 0u; wire_idx < n_wires; ++wire_idx ) {
+                auto const size_with_flags = _d->m_puiSizesWires[wire_idx];
+                _offsets[wire_idx] = offset;
+                _closed[wire_idx] = 0u != (size_with_flags & kA3DTess3DWireDataIsClosing);
+                _connected_to_previous[wire_idx] = 0u != (size_with_flags & kA3DTess3DWireDataIsContinuous);
+                offset += size_with_flags & ~(kA3DTess3DWireDataIsClosing | kA3DTess3DWireDataIsContinuous);
+            }
+            if( offset > _d->m_uiWireIndexesSize ) {
+                throw std::out_of_range( "Wire sizes exceed the number of wire indexes." );
+            }
+            _offsets[n_wires] = offset;
+
+            auto const channels = _d->m_bIsRGBA ? 4u : 3u;
+            auto const colors = _d->m_pucRGBAVertices;
+            _colors.resize( nullptr == colors ? 0u : _d->m_uiRGBAVerticesSize / channels );
+            for( auto color_idx = 0u; color_idx < _colors.size(); ++color_idx ) {
+                auto const rgba = colors + channels * color_idx;
+                auto const alpha = _d->m_bIsRGBA ? rgba[3] : A3DUns8( 255u );
+                _colors[color_idx] = static_cast<A3DUns32>( rgba[0] ) | (static_cast<A3DUns32>( rgba[1] ) << 8) | (static_cast<A3DUns32>( rgba[2] ) << 16) | (static_cast<A3DUns32>( alpha ) << 24);
+            }
+        }
+        
+        /*! \brief Gets the number of wires
          */
-        double const *texCoords( void ) const {
-            return _d->m_pdTextureCoords;
+        A3DUns32 getNumberOfWires( void ) const {
+            return static_cast<A3DUns32>( _closed.size() );
         }
 
-        /*! \brief Provides the length of the texCoords array.
+        /*! \brief Gets the point offsets of all wires. Each value is the
+         *  offset of a point in the TessBaseInstance::coords() array. The
+         *  length of this array is determined by verticesSize().
          */
-        A3DUns32 texCoordsSize( void ) const {
-            return _d->m_uiTextureCoordSize;
+        A3DUns32 const *vertices( void ) const {
+            return _d->m_puiWireIndexes;
         }
-        
-        /*! \brief Provides the total number of faces with available
-         *  tessellation data. \sa getIndexMeshForFace
+
+        /*! \brief Provides the length of the vertices() array.
          */
-        A3DUns32 faceSize( void ) const {
-            return _d->m_uiFaceTessSize;
+        A3DUns32 verticesSize( void ) const {
+            return _offsets.back();
         }
 
-        /*! \brief Gets an object that wraps the tessellation data of
-         *  a given face.
-         * \param face_idx Index of the face to obtain the access helper for.
-         *  Valid index values must fall in the interval [0, faceSize()).
+        /*! \brief Gets the offset of the first vertex of each wire in the
+         *  vertices() array, followed by verticesSize(). The vertices of
+         *  wire \c i are <tt>[offsets()[i], offsets()[i + 1])</tt>.
          */
-        TessFaceDataHelper getIndexMeshForFace( A3DUns32 const &face_idx ) const {
-            if( face_idx >= _d->m_uiFaceTessSize ) {
-                throw std::out_of_range( "Index of face requested for index mesh is out of range." );
-            }
-            return TessFaceDataHelper( _d->m_psFaceTessData[face_idx], _d->m_puiTriangulatedIndexes, _d->m_puiWireIndexes );
+        std::vector<A3DUns32> const &offsets( void ) const {
+            return _offsets;
         }
-        
-    private:
-        A3DTess3DWrapper _d;
-    };
 
-    /*! \brief Provides easy access to wire tessellation data.
-     *  \ingroup access
-     *  \todo Incomplete
-     */
-    class Tess3DWireInstance : public TessBaseInstance {
-    public:
-        /*! \brief Constructor
-         */
-        Tess3DWireInstance( InstancePath const &path );
-        
-        /*! \brief Gets the number of wires
+        /*! \brief Gets a flag per wire, set if the wire is closed, that is,
+         *  its last vertex connects back to its first.
          */
-        A3DUns32 getNumberOfWires( void ) const;
-        
-        /*! \brief Structure describing wire data
+        std::vector<bool> const &closed( void ) const {
+            return _closed;
+        }
+
+        /*! \brief Gets a flag per wire, set if the wire continues from the
+         *  last vertex of the previous wire.
          */
-        struct WireData {
-            /*! \brief The vertex index values */
-            std::vector<A3DUns32> _vertices;
-            /*! \brief Indicated if the wire is closing */
-            bool _closed;
-            /*! \brief Indicates if the wire is connected to the previous wire */
-            bool _connected_to_previous;
-        };
+        std::vector<bool> const &connectedToPrevious( void ) const {
+            return _connected_to_previous;
+        }
         
         /*! \brief How color is specified
          */
@@ -2328,7 +5657,9 @@ namespace ts3d {
         };
 
         /*! \brief Hos is the color specified? */
-        ColorSpec getColorSpecification( void ) const;
+        ColorSpec getColorSpecification( void ) const {
+            return _d->m_bIsRGBA ? ColorSpec::RGBA : ColorSpec::RGB;
+        }
         
         /*! \brief How is the color applied? */
         enum class ColorApplication {
@@ -2337,11 +5668,459 @@ namespace ts3d {
             /*! \brief Per wire segment color */
             PerSegment
         };
+
+        /*! \brief Are colors() given per vertex or per segment? */
+        ColorApplication getColorApplication( void ) const {
+            return _d->m_bIsSegmentColor ? ColorApplication::PerSegment : ColorApplication::PerVertex;
+        }
+
+        /*! \brief Gets the colors of the wires, or an empty array if the
+         *  wires are not colored. Per vertex colors parallel the vertices()
+         *  array. Each color is packed as <tt>0xAABBGGRR</tt>, so that its bytes
+         *  are in R, G, B, A order on little endian machines. The alpha of RGB
+         *  colors is 255.
+         */
+        std::vector<A3DUns32> const &colors( void ) const {
+            return _colors;
+        }
         
     private:
         /*! \private */
         A3DTess3DWireWrapper _d;
+        std::vector<A3DUns32> _offsets;
+        std::vector<bool> _closed;
+        std::vector<bool> _connected_to_previous;
+        std::vector<A3DUns32> _colors;
+    };
+
+    /*! \brief Decodes markup tessellation into batched primitive buffers.
+     *
+     * The code stream of an \c A3DTessMarkup interleaves primitives with
+     * changes to the drawing state: color, line width, line stipple, font,
+     * transformation matrix and the face view, frame draw and fixed size
+     * modes. The stream is decoded in a single pass when the object is
+     * constructed.
+     *
+     * Polylines, triangles, points and text runs are stored in flat buffers.
+     * Consecutive primitives drawn with the same state are grouped into a
+     * Batch, which references a contiguous range of each buffer. Each distinct
+     * state is stored once, so batches may also be grouped by State index.
+     * Patterns, pictures, symbols and cylinders are not decoded.
+     *  \ingroup access
+     */
+    class TessMarkupInstance : public TessBaseInstance {
+    public:
+        /*! \brief Flags for the modes of a State
+         */
+        enum Mode : A3DUns32 {
+            /*! \brief Primitives face the viewer, rotating about State::_anchor */
+            FaceView = 0x1,
+            /*! \brief Primitives are drawn in screen space, positioned at State::_anchor */
+            FrameDraw = 0x2,
+            /*! \brief Primitives keep a constant screen size, scaling about State::_anchor */
+            FixedSize = 0x4,
+            /*! \brief Lines are stippled with State::_line_stipple */
+            LineStipple = 0x8
+        };
+
+        /*! \brief The drawing state of a batch of primitives
+         */
+        struct State {
+            /*! \brief Index of the transformation in matrices(), or \c ~0u if there is none */
+            A3DUns32 _matrix;
+            /*! \brief Index of the global RGB color, or \c A3D_DEFAULT_COLOR_INDEX */
+            A3DUns32 _color;
+            /*! \brief Combination of Mode flags */
+            A3DUns32 _modes;
+            /*! \brief The code of the line stipple pattern, if LineStipple is set */
+            A3DUns32 _line_stipple;
+            /*! \brief The two codes of the font extra data, or \c ~0u if no font was set */
+            A3DUns32 _font[2];
+            /*! \brief The line width, or 0 for the default width */
+            double _line_width;
+            /*! \brief The anchor point of the innermost FaceView, FrameDraw or FixedSize mode */
+            double _anchor[3];
+        };
+
+        /*! \brief A text drawn with the transformation and font of its State
+         */
+        struct TextRun {
+            /*! \brief Index of the text, see getText() */
+            A3DUns32 _text;
+            /*! \brief Width of the text box */
+            double _width;
+            /*! \brief Height of the text box */
+            double _height;
+        };
+
+        /*! \brief Consecutive primitives sharing a State. Each range is
+         * [first, second) and counts primitives of the corresponding buffer.
+         */
+        struct Batch {
+            /*! \brief Index in states() */
+            A3DUns32 _state;
+            /*! \brief Range of polylines, see polylineOffsets() */
+            std::pair<A3DUns32, A3DUns32> _polylines;
+            /*! \brief Range of triangles, see triangles() */
+            std::pair<A3DUns32, A3DUns32> _triangles;
+            /*! \brief Range of points, see points() */
+            std::pair<A3DUns32, A3DUns32> _points;
+            /*! \brief Range of text runs, see texts() */
+            std::pair<A3DUns32, A3DUns32> _texts;
+        };
+
+        /*! \brief Throws if leaf type is not kA3DTypeTessMarkup, or if the
+         * code stream refers to more codes or coordinates than it holds.
+         */
+        TessMarkupInstance( InstancePath const &path )
+        : TessBaseInstance( path ) {
+            if( kA3DTypeTessMarkup != leafType() ) {
+                throw std::invalid_argument( "Expected A3DTessMarkup leaf node type." );
+            }
+            _d.reset( leaf() );
+            decode();
+        }
+
+        /*! \brief Gets the batches, in drawing order.
+         */
+        std::vector<Batch> const &batches( void ) const {
+            return _batches;
+        }
+
+        /*! \brief Gets the distinct states referenced by batches().
+         */
+        std::vector<State> const &states( void ) const {
+            return _states;
+        }
+
+        /*! \brief Gets the transformations referenced by states(), as 16
+         * column major values each. Nested transformations are already
+         * multiplied together.
+         */
+        std::vector<double> const &matrices( void ) const {
+            return _matrices;
+        }
+
+        /*! \brief Gets the points of all polylines, three values per point.
+         */
+        std::vector<double> const &polylinePoints( void ) const {
+            return _polyline_points;
+        }
+
+        /*! \brief Gets the index of the first point of each polyline in
+         * polylinePoints(), followed by the total number of points. Polyline
+         * \c i has the points <tt>[polylineOffsets()[i], polylineOffsets()[i + 1])</tt>.
+         */
+        std::vector<A3DUns32> const &polylineOffsets( void ) const {
+            return _polyline_offsets;
+        }
+
+        /*! \brief Gets the filled triangles, nine values per triangle. Quads
+         * and polygons are decomposed into triangles.
+         */
+        std::vector<double> const &triangles( void ) const {
+            return _triangles;
+        }
+
+        /*! \brief Gets the points, three values per point.
+         */
+        std::vector<double> const &points( void ) const {
+            return _points;
+        }
+
+        /*! \brief Gets the text runs.
+         */
+        std::vector<TextRun> const &texts( void ) const {
+            return _texts;
+        }
+
+        /*! \brief Gets a text of the markup.
+         * \param text_idx The TextRun::_text of a text run.
+         */
+        std::string getText( A3DUns32 const text_idx ) const {
+            if( text_idx >= _d->m_uiTextsSize ) {
+                throw std::out_of_range( "Index of markup text is out of range." );
+            }
+            return _d->m_ppcTexts[text_idx] ? _d->m_ppcTexts[text_idx] : std::string();
+        }
+
+    private:
+        inline void decode( void );
+
+        A3DTessMarkupWrapper _d;
+        std::vector<Batch> _batches;
+        std::vector<State> _states;
+        std::vector<double> _matrices;
+        std::vector<double> _polyline_points;
+        std::vector<A3DUns32> _polyline_offsets;
+        std::vector<double> _triangles;
+        std::vector<double> _points;
+        std::vector<TextRun> _texts;
+    };
+}
+
+namespace {
+    static inline bool isSameMarkupState( ts3d::TessMarkupInstance::State const &lhs, ts3d::TessMarkupInstance::State const &rhs ) {
+        return lhs._matrix == rhs._matrix && lhs._color == rhs._color && lhs._modes == rhs._modes &&
+            lhs._line_stipple == rhs._line_stipple && lhs._font[0] == rhs._font[0] && lhs._font[1] == rhs._font[1] &&
+            lhs._line_width == rhs._line_width && std::equal( lhs._anchor, lhs._anchor + 3, rhs._anchor );
+    }
+
+    // Styles are compared member by member, since the padding between
+    // the members of A3DGraphStyleData is not initialized
+    static inline bool isSameStyle( A3DGraphStyleData const &lhs, A3DGraphStyleData const &rhs ) {
+        return std::tie( lhs.m_dWidth, lhs.m_bVPicture, lhs.m_uiLinePatternIndex, lhs.m_bMaterial, lhs.m_uiRgbColorIndex,
+            lhs.m_bIsTransparencyDefined, lhs.m_ucTransparency, lhs.m_bSpecialCulling, lhs.m_bFrontCulling, lhs.m_bBackCulling,
+            lhs.m_bNoLight, lhs.m_eRenderingMode ) ==
+            std::tie( rhs.m_dWidth, rhs.m_bVPicture, rhs.m_uiLinePatternIndex, rhs.m_bMaterial, rhs.m_uiRgbColorIndex,
+            rhs.m_bIsTransparencyDefined, rhs.m_ucTransparency, rhs.m_bSpecialCulling, rhs.m_bFrontCulling, rhs.m_bBackCulling,
+            rhs.m_bNoLight, rhs.m_eRenderingMode );
+    }
+
+    static inline bool isStyleLess( A3DGraphStyleData const &lhs, A3DGraphStyleData const &rhs ) {
+        return std::tie( lhs.m_dWidth, lhs.m_bVPicture, lhs.m_uiLinePatternIndex, lhs.m_bMaterial, lhs.m_uiRgbColorIndex,
+            lhs.m_bIsTransparencyDefined, lhs.m_ucTransparency, lhs.m_bSpecialCulling, lhs.m_bFrontCulling, lhs.m_bBackCulling,
+            lhs.m_bNoLight, lhs.m_eRenderingMode ) <
+            std::tie( rhs.m_dWidth, rhs.m_bVPicture, rhs.m_uiLinePatternIndex, rhs.m_bMaterial, rhs.m_uiRgbColorIndex,
+            rhs.m_bIsTransparencyDefined, rhs.m_ucTransparency, rhs.m_bSpecialCulling, rhs.m_bFrontCulling, rhs.m_bBackCulling,
+            rhs.m_bNoLight, rhs.m_eRenderingMode );
+    }
+
+    // Computes result = lhs * rhs, where all matrices are 4x4 column major
+    // and result does not overlap either operand
+    static inline void multiplyMatrices( double const *lhs, double const *rhs, double *result ) {
+        for( auto col = 0u; col < 4u; ++col ) {
+            for( auto row = 0u; row < 4u; ++row ) {
+                auto value = 0.;
+                for( auto k = 0u; k < 4u; ++k ) {
+                    value += lhs[k * 4u + row] * rhs[col * 4u + k];
+                }
+                result[col * 4u + row] = value;
+            }
+        }
+    }
+}
+
+void ts3d::TessMarkupInstance::decode( void ) {
+    auto const codes = _d->m_puiCodes;
+    auto const n_codes = _d->m_uiCodesSize;
+    auto const coords = this->coords();
+    auto const n_coords = coordsSize();
+
+    State state;
+    state._matrix = ~0u;
+    state._color = A3D_DEFAULT_COLOR_INDEX;
+    state._modes = 0u;
+    state._line_stipple = 0u;
+    state._font[0] = state._font[1] = ~0u;
+    state._line_width = 0.;
+    state._anchor[0] = state._anchor[1] = state._anchor[2] = 0.;
+
+    // Matrices, modes and stipples are begun by an entity carrying data and
+    // ended by an empty entity of the same kind. Blocks of different kinds may
+    // overlap, so each kind has its own stack and only restores its own fields.
+    // The face view, frame draw and fixed size modes share a stack, and each
+    // end is matched with the innermost block of the same mode.
+    // Colors, line widths and fonts are not scoped.
+    struct SavedMode {
+        A3DUns32 _mode;
+        A3DUns32 _modes;
+        double _anchor[3];
+    };
+    struct SavedStipple {
+        A3DUns32 _modes;
+        A3DUns32 _line_stipple;
+    };
+    std::vector<A3DUns32> matrix_stack;
+    std::vector<SavedMode> mode_stack;
+    std::vector<SavedStipple> stipple_stack;
+    auto const endMatrix = [&state, &matrix_stack]( void ) {
+        if( !matrix_stack.empty() ) {
+            state._matrix = matrix_stack.back();
+            matrix_stack.pop_back();
+        }
+    };
+    // Ends the innermost block of the given mode, which may have been
+    // overlapped by a later block of another mode. The anchor belongs to the
+    // innermost block, so it is only restored if that is the block ending.
+    // Otherwise the block begun after it inherits the anchor to restore.
+    auto const endMode = [&state, &mode_stack]( A3DUns32 const mode ) {
+        auto const it = std::find_if( mode_stack.rbegin(), mode_stack.rend(), [mode]( SavedMode const &saved ) {
+            return saved._mode == mode;
+        });
+        if( it == mode_stack.rend() ) {
+            return;
+        }
+        state._modes = (state._modes & ~mode) | (it->_modes & mode);
+        if( it == mode_stack.rbegin() ) {
+            std::copy( it->_anchor, it->_anchor + 3, state._anchor );
+        } else {
+            std::copy( it->_anchor, it->_anchor + 3, std::prev( it )->_anchor );
+        }
+        mode_stack.erase( std::prev( it.base() ) );
+    };
+    auto const endStipple = [&state, &stipple_stack]( void ) {
+        if( !stipple_stack.empty() ) {
+            auto const &saved = stipple_stack.back();
+            state._modes = (state._modes & ~LineStipple) | (saved._modes & LineStipple);
+            state._line_stipple = saved._line_stipple;
+            stipple_stack.pop_back();
+        }
+    };
+
+    // Gets the batch for primitives drawn with the current state
+    auto const currentBatch = [this, &state]( void ) -> Batch & {
+        if( _batches.empty() || !isSameMarkupState( _states[_batches.back()._state], state ) ) {
+            auto const it = std::find_if( _states.begin(), _states.end(), [&state]( State const &other ) {
+                return isSameMarkupState( other, state );
+            });
+            auto const state_idx = static_cast<A3DUns32>( it - _states.begin() );
+            if( _states.end() == it ) {
+                _states.push_back( state );
+            }
+            auto const n_polylines = static_cast<A3DUns32>( _polyline_offsets.size() - 1u );
+            auto const n_triangles = static_cast<A3DUns32>( _triangles.size() / 9u );
+            auto const n_points = static_cast<A3DUns32>( _points.size() / 3u );
+            auto const n_texts = static_cast<A3DUns32>( _texts.size() );
+            Batch const batch = { state_idx, { n_polylines, n_polylines }, { n_triangles, n_triangles }, { n_points, n_points }, { n_texts, n_texts } };
+            _batches.push_back( batch );
+        }
+        return _batches.back();
+    };
+    auto const appendTriangle = [this]( double const *p0, double const *p1, double const *p2 ) {
+        _triangles.insert( _triangles.end(), p0, p0 + 3 );
+        _triangles.insert( _triangles.end(), p1, p1 + 3 );
+        _triangles.insert( _triangles.end(), p2, p2 + 3 );
     };
+
+    _polyline_offsets.push_back( 0u );
+    auto code_idx = 0u;
+    auto coord_idx = 0u;
+    while( code_idx < n_codes ) {
+        if( code_idx + 1u >= n_codes ) {
+            throw std::out_of_range( "Markup code stream is truncated." );
+        }
+        auto const code = codes[code_idx];
+        auto const n_ints = code & kA3DMarkupIntegerMask;
+        auto const n_doubles = codes[code_idx + 1u];
+        if( n_ints > n_codes - code_idx - 2u || n_doubles > n_coords - coord_idx ) {
+            throw std::out_of_range( "Markup code stream exceeds its data." );
+        }
+        auto const ints = codes + code_idx + 2u;
+        auto const doubles = coords + coord_idx;
+        code_idx += 2u + n_ints;
+        coord_idx += n_doubles;
+
+        if( code & kA3DMarkupIsMatrix ) {
+            if( n_doubles < 16u ) {
+                endMatrix();
+                continue;
+            }
+            matrix_stack.push_back( state._matrix );
+            auto const matrix_idx = static_cast<A3DUns32>( _matrices.size() / 16u );
+            if( ~0u == state._matrix ) {
+                _matrices.insert( _matrices.end(), doubles, doubles + 16 );
+            } else {
+                double matrix[16];
+                multiplyMatrices( _matrices.data() + 16u * state._matrix, doubles, matrix );
+                _matrices.insert( _matrices.end(), matrix, matrix + 16 );
+            }
+            state._matrix = matrix_idx;
+            continue;
+        }
+
+        if( !(code & kA3DMarkupIsExtraData) ) {
+            auto &batch = currentBatch();
+            _polyline_points.insert( _polyline_points.end(), doubles, doubles + 3u * (n_doubles / 3u) );
+            _polyline_offsets.push_back( static_cast<A3DUns32>( _polyline_points.size() / 3u ) );
+            batch._polylines.second = static_cast<A3DUns32>( _polyline_offsets.size() - 1u );
+            continue;
+        }
+
+        switch( A3D_DECODE_EXTRA_DATA( code ) ) {
+            case kA3DMarkupFaceViewExtraData:
+            case kA3DMarkupFrameDrawExtraData:
+            case kA3DMarkupFixedSizeExtraData: {
+                auto const extra_data_type = A3D_DECODE_EXTRA_DATA( code );
+                auto const mode = kA3DMarkupFaceViewExtraData == extra_data_type ? FaceView : (kA3DMarkupFrameDrawExtraData == extra_data_type ? FrameDraw : FixedSize);
+                if( n_doubles < 3u ) {
+                    endMode( mode );
+                } else {
+                    SavedMode const saved = { static_cast<A3DUns32>( mode ), state._modes, { state._anchor[0], state._anchor[1], state._anchor[2] } };
+                    mode_stack.push_back( saved );
+                    state._modes |= mode;
+                    std::copy( doubles, doubles + 3, state._anchor );
+                }
+                break;
+            }
+            case kA3DMarkupLineStippleExtraData:
+                if( 0u == n_ints ) {
+                    endStipple();
+                } else {
+                    SavedStipple const saved = { state._modes, state._line_stipple };
+                    stipple_stack.push_back( saved );
+                    state._modes |= LineStipple;
+                    state._line_stipple = ints[0];
+                }
+                break;
+            case kA3DMarkupColorExtraData:
+                if( n_ints > 0u ) {
+                    state._color = ints[0];
+                }
+                break;
+            case kA3DMarkupLineWidthExtraData:
+                if( n_doubles > 0u ) {
+                    state._line_width = doubles[0];
+                }
+                break;
+            case kA3DMarkupFontExtraData:
+                if( n_ints > 1u ) {
+                    state._font[0] = ints[0];
+                    state._font[1] = ints[1];
+                }
+                break;
+            case kA3DMarkupTrianglesExtraData: {
+                auto &batch = currentBatch();
+                _triangles.insert( _triangles.end(), doubles, doubles + 9u * (n_doubles / 9u) );
+                batch._triangles.second = static_cast<A3DUns32>( _triangles.size() / 9u );
+                break;
+            }
+            case kA3DMarkupQuadsExtraData: {
+                auto &batch = currentBatch();
+                for( auto quad = doubles; quad + 12 <= doubles + n_doubles; quad += 12 ) {
+                    appendTriangle( quad, quad + 3, quad + 6 );
+                    appendTriangle( quad, quad + 6, quad + 9 );
+                }
+                batch._triangles.second = static_cast<A3DUns32>( _triangles.size() / 9u );
+                break;
+            }
+            case kA3DMarkupPolygonExtraData: {
+                auto &batch = currentBatch();
+                auto const n_vertices = n_doubles / 3u;
+                for( auto vertex = 1u; vertex + 1u < n_vertices; ++vertex ) {
+                    appendTriangle( doubles, doubles + 3u * vertex, doubles + 3u * (vertex + 1u) );
+                }
+                batch._triangles.second = static_cast<A3DUns32>( _triangles.size() / 9u );
+                break;
+            }
+            case kA3DMarkupPointsExtraData: {
+                auto &batch = currentBatch();
+                _points.insert( _points.end(), doubles, doubles + 3u * (n_doubles / 3u) );
+                batch._points.second = static_cast<A3DUns32>( _points.size() / 3u );
+                break;
+            }
+            case kA3DMarkupTextExtraData:
+                if( n_ints > 0u ) {
+                    auto &batch = currentBatch();
+                    TextRun const text_run = { ints[0], n_doubles > 0u ? doubles[0] : 0., n_doubles > 1u ? doubles[1] : 0. };
+                    _texts.push_back( text_run );
+                    batch._texts.second = static_cast<A3DUns32>( _texts.size() );
+                }
+                break;
+            default:
+                break;
+        }
+    }
 }
 
 namespace ts3d {
@@ -2363,11 +6142,11 @@ namespace ts3d {
         /*! \brief Provides a concrete type for the tessellation instance
          * Will be one of type:
          * - Tess3DInstance
+         * - Tess3DWireInstance
          */
         std::shared_ptr<TessBaseInstance> getTessellation( void ) const {
             A3DRiRepresentationItemWrapper d( leaf() );
-            auto tess_type = kA3DTypeUnknown;
-            A3DEntityGetType( d->m_pTessBase, &tess_type );
+            auto const tess_type = getEntityType( d->m_pTessBase );
             auto tess_path = path();
             tess_path.push_back( d->m_pTessBase );
             switch( tess_type ) {
@@ -2375,6 +6154,7 @@ namespace ts3d {
                     return std::make_shared<Tess3DInstance>( tess_path );
                     break;
                 case kA3DTypeTess3DWire:
+                    return std::make_shared<Tess3DWireInstance>( tess_path );
                     break;
                 default:
                     break;
@@ -2384,6 +6164,22 @@ namespace ts3d {
         
         /** @name Net attribute getters */
         /**@{*/
+        /*! \brief Gets the net attributes of all faces in a single pass.
+         * This is much faster than calling the per face getters for each face,
+         * since the tessellation is read once. Representation items without
+         * face tessellation have no faces.
+         */
+        FaceNetAttributes getFaceNetAttributes( void ) const {
+            return computeFaceNetAttributes( getCascadedAttributes() );
+        }
+
+        /*! \brief Gets the net attributes of all faces in a single pass, obtaining
+         * the cascaded attributes of this instance from \c cache.
+         */
+        FaceNetAttributes getFaceNetAttributes( CascadedAttributesCache &cache ) const {
+            return computeFaceNetAttributes( cache.getCascadedAttributes( path() ) );
+        }
+
         /*! \brief Gets the net removed
          */
         bool getNetRemoved( A3DUns32 const face_idx ) const {
@@ -2410,12 +6206,49 @@ namespace ts3d {
         }
         /**@}*/
 
-    protected:
+    private:
+        /*! \private */
+        FaceNetAttributes computeFaceNetAttributes( A3DMiscCascadedAttributes *father ) const {
+            FaceNetAttributes result;
+            A3DRiRepresentationItemWrapper d( leaf() );
+            if( kA3DTypeTess3D != getEntityType( d->m_pTessBase ) ) {
+                return result;
+            }
+            A3DTess3DWrapper tess_d( d->m_pTessBase );
+            auto const face_count = tess_d->m_uiFaceTessSize;
+            result._style_indices.reserve( face_count );
+            result._removed.reserve( face_count );
+            result._show.reserve( face_count );
+            result._layers.reserve( face_count );
+
+            std::map<A3DGraphStyleData, A3DUns32, decltype( &isStyleLess )> style_indices( &isStyleLess );
+            for( auto face_idx = 0u; face_idx < face_count; ++face_idx ) {
+                ApiLock const lock;
+                A3DMiscCascadedAttributes *attrib = nullptr;
+                CheckResult( A3DMiscCascadedAttributesCreate( &attrib ) );
+                CheckResult( A3DMiscCascadedAttributesPushTessFace( attrib, leaf(), d->m_pTessBase, &tess_d->m_psFaceTessData[face_idx], face_idx, father ) );
+                {
+                    A3DMiscCascadedAttributesWrapper attrib_d( attrib );
+                    auto const style = style_indices.emplace( attrib_d->m_sStyle, static_cast<A3DUns32>( result._styles.size() ) );
+                    if( style.second ) {
+                        result._styles.push_back( attrib_d->m_sStyle );
+                    }
+                    result._style_indices.push_back( style.first->second );
+                    result._removed.push_back( A3D_TRUE == attrib_d->m_bRemoved );
+                    result._show.push_back( A3D_TRUE == attrib_d->m_bShow );
+                    result._layers.push_back( attrib_d->m_usLayer );
+                }
+                CheckResult( A3DMiscCascadedAttributesDelete( attrib ) );
+            }
+            return result;
+        }
+
         A3DMiscCascadedAttributesWrapper getCascadedAttributesData( A3DUns32 const face_idx ) const {
             if( _cascaded_attribs.empty() ) {
                 getCascadedAttributes();
             }
 
+            ApiLock const lock;
             auto cascaded_attribs_copy = _cascaded_attribs;
             auto father = cascaded_attribs_copy.back();
             cascaded_attribs_copy.push_back( nullptr );
@@ -2568,6 +6401,263 @@ namespace ts3d {
     }
 }
 
+namespace ts3d {
+    /*! \brief An InterleavedMesh converted to single precision.
+     *
+     * Positions are stored relative to _origin, so large coordinate values
+     * do not cost precision. Normals and texture coordinates are unchanged
+     * apart from the conversion.
+     * \sa toFloat32
+     * \ingroup access
+     */
+    struct Float32Mesh {
+        /*! \brief The position subtracted from each vertex position */
+        A3DVector3dData _origin;
+        /*! \brief Number of values per vertex, as for InterleavedMesh::_stride */
+        A3DUns32 _stride;
+        /*! \brief Vertex values, _stride per vertex */
+        std::vector<float> _vertices;
+        /*! \brief Vertex indexes, three per triangle */
+        std::vector<A3DUns32> _indices;
+        /*! \brief Range [first, second) of triangles belonging to each face */
+        std::vector<std::pair<A3DUns32, A3DUns32>> _face_triangles;
+
+        /*! \brief Gets the number of vertices */
+        size_t vertexCount( void ) const {
+            return _stride ? _vertices.size() / _stride : 0u;
+        }
+    };
+
+    /*! \brief An InterleavedMesh in a compact, quantized form.
+     *
+     * Each position component is stored as a 16 bit value \c q, where
+     * the position is <tt>_origin + q * _scale</tt> per component. Normals
+     * are octahedral encoded as two 16 bit values, see decodeOctahedralNormal().
+     * Texture coordinates are stored as half floats, see fromHalf().
+     * \sa quantize
+     * \ingroup access
+     */
+    struct QuantizedMesh {
+        /*! \brief The position of a quantized value of 0 */
+        A3DVector3dData _origin;
+        /*! \brief The size of a quantization step along each axis */
+        A3DVector3dData _scale;
+        /*! \brief Quantized positions, three per vertex */
+        std::vector<A3DUns16> _positions;
+        /*! \brief Octahedral encoded normals, two per vertex */
+        std::vector<A3DInt16> _normals;
+        /*! \brief Half float texture coordinates, two per vertex, or empty */
+        std::vector<A3DUns16> _texture_coords;
+        /*! \brief Vertex indexes, three per triangle */
+        std::vector<A3DUns32> _indices;
+        /*! \brief Range [first, second) of triangles belonging to each face */
+        std::vector<std::pair<A3DUns32, A3DUns32>> _face_triangles;
+
+        /*! \brief Gets the number of vertices */
+        size_t vertexCount( void ) const {
+            return _positions.size() / 3u;
+        }
+    };
+
+    /*! \brief Gets the bounding box of the vertex positions of a mesh.
+     * The box of an empty mesh is empty and centered at the origin.
+     * \ingroup access
+     */
+    static inline A3DBoundingBoxData getBoundingBox( InterleavedMesh const &mesh );
+
+    /*! \brief Converts a mesh to single precision, with positions relative
+     * to the center of its bounding box.
+     * \ingroup access
+     */
+    static inline Float32Mesh toFloat32( InterleavedMesh const &mesh );
+
+    /*! \brief Converts a mesh to single precision, with positions relative
+     * to \c origin. Use this to share an origin between meshes, such as the
+     * center of the bounding box of a part or of an instance.
+     * \ingroup access
+     */
+    static inline Float32Mesh toFloat32( InterleavedMesh const &mesh, A3DVector3dData const &origin );
+
+    /*! \brief Quantizes a mesh. Positions are quantized over the bounding
+     * box of the mesh, so the error along each axis is at most half of
+     * QuantizedMesh::_scale.
+     * \ingroup access
+     */
+    static inline QuantizedMesh quantize( InterleavedMesh const &mesh );
+
+    /*! \brief Encodes a unit normal vector as two signed normalized 16 bit values
+     * using the octahedral mapping.
+     * \ingroup access
+     */
+    static inline void encodeOctahedralNormal( double const *normal, A3DInt16 *encoded );
+
+    /*! \brief Decodes an octahedral encoded normal vector into a unit vector.
+     * \ingroup access
+     */
+    static inline void decodeOctahedralNormal( A3DInt16 const *encoded, double *normal );
+
+    /*! \brief Converts a value to an IEEE 754 half float, rounding to nearest even.
+     * \ingroup access
+     */
+    static inline A3DUns16 toHalf( float const value );
+
+    /*! \brief Converts an IEEE 754 half float to float.
+     * \ingroup access
+     */
+    static inline float fromHalf( A3DUns16 const half );
+}
+
+namespace {
+    static inline double signNotZero( double const value ) {
+        return value < 0. ? -1. : 1.;
+    }
+
+    static inline A3DInt16 toSnorm16( double const value ) {
+        return static_cast<A3DInt16>( std::round( std::min( std::max( value, -1. ), 1. ) * 32767. ) );
+    }
+}
+
+A3DBoundingBoxData ts3d::getBoundingBox( InterleavedMesh const &mesh ) {
+    A3DBoundingBoxData result;
+    A3D_INITIALIZE_DATA( A3DBoundingBoxData, result );
+    result.m_sMin = result.m_sMax = zeroVector();
+    for( auto idx = 0u; idx < mesh.vertexCount(); ++idx ) {
+        auto const position = mesh._vertices.data() + mesh._stride * idx;
+        A3DVector3dData pt;
+        A3D_INITIALIZE_DATA( A3DVector3dData, pt );
+        pt.m_dX = position[0];
+        pt.m_dY = position[1];
+        pt.m_dZ = position[2];
+        if( idx != 0u ) {
+            include( result, pt );
+        } else {
+            result.m_sMin = result.m_sMax = pt;
+        }
+    }
+    return result;
+}
+
+ts3d::Float32Mesh ts3d::toFloat32( InterleavedMesh const &mesh ) {
+    return toFloat32( mesh, center( getBoundingBox( mesh ) ) );
+}
+
+ts3d::Float32Mesh ts3d::toFloat32( InterleavedMesh const &mesh, A3DVector3dData const &origin ) {
+    Float32Mesh result;
+    result._origin = origin;
+    result._stride = mesh._stride;
+    result._vertices.resize( mesh._vertices.size() );
+    result._indices = mesh._indices;
+    result._face_triangles = mesh._face_triangles;
+    double const offsets[] = { origin.m_dX, origin.m_dY, origin.m_dZ };
+    for( auto idx = 0u; idx < result._vertices.size(); ++idx ) {
+        auto const component = idx % mesh._stride;
+        auto const offset = component < 3u ? offsets[component] : 0.;
+        result._vertices[idx] = static_cast<float>( mesh._vertices[idx] - offset );
+    }
+    return result;
+}
+
+ts3d::QuantizedMesh ts3d::quantize( InterleavedMesh const &mesh ) {
+    QuantizedMesh result;
+    auto const bb = getBoundingBox( mesh );
+    auto const extent = bb.m_sMax - bb.m_sMin;
+    auto const steps = static_cast<double>( std::numeric_limits<A3DUns16>::max() );
+    result._origin = bb.m_sMin;
+    result._scale = extent / steps;
+    result._indices = mesh._indices;
+    result._face_triangles = mesh._face_triangles;
+
+    auto const n_vertices = mesh.vertexCount();
+    auto const textured = mesh._stride > 6u;
+    result._positions.resize( 3u * n_vertices );
+    result._normals.resize( 2u * n_vertices );
+    result._texture_coords.resize( textured ? 2u * n_vertices : 0u );
+
+    double const origin[] = { bb.m_sMin.m_dX, bb.m_sMin.m_dY, bb.m_sMin.m_dZ };
+    double const scale[] = { result._scale.m_dX, result._scale.m_dY, result._scale.m_dZ };
+    for( auto idx = 0u; idx < n_vertices; ++idx ) {
+        auto const vertex = mesh._vertices.data() + mesh._stride * idx;
+        for( auto axis = 0u; axis < 3u; ++axis ) {
+            auto const q = scale[axis] > 0. ? std::round( (vertex[axis] - origin[axis]) / scale[axis] ) : 0.;
+            result._positions[3u * idx + axis] = static_cast<A3DUns16>( std::min( std::max( q, 0. ), steps ) );
+        }
+        encodeOctahedralNormal( vertex + 3, result._normals.data() + 2u * idx );
+        if( textured ) {
+            result._texture_coords[2u * idx] = toHalf( static_cast<float>( vertex[6] ) );
+            result._texture_coords[2u * idx + 1u] = toHalf( static_cast<float>( vertex[7] ) );
+        }
+    }
+    return result;
+}
+
+void ts3d::encodeOctahedralNormal( double const *normal, A3DInt16 *encoded ) {
+    auto const l1_norm = std::fabs( normal[0] ) + std::fabs( normal[1] ) + std::fabs( normal[2] );
+    if( l1_norm <= 0. ) {
+        encoded[0] = encoded[1] = 0;
+        return;
+    }
+
+    // Project onto the octahedron, then fold the lower half over the upper
+    auto x = normal[0] / l1_norm;
+    auto y = normal[1] / l1_norm;
+    if( normal[2] < 0. ) {
+        auto const folded_x = (1. - std::fabs( y )) * signNotZero( x );
+        y = (1. - std::fabs( x )) * signNotZero( y );
+        x = folded_x;
+    }
+    encoded[0] = toSnorm16( x );
+    encoded[1] = toSnorm16( y );
+}
+
+void ts3d::decodeOctahedralNormal( A3DInt16 const *encoded, double *normal ) {
+    auto x = std::max( encoded[0] / 32767., -1. );
+    auto y = std::max( encoded[1] / 32767., -1. );
+    auto const z = 1. - std::fabs( x ) - std::fabs( y );
+    if( z < 0. ) {
+        auto const unfolded_x = (1. - std::fabs( y )) * signNotZero( x );
+        y = (1. - std::fabs( x )) * signNotZero( y );
+        x = unfolded_x;
+    }
+    auto const length = std::sqrt( x * x + y * y + z * z );
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+A3DUns16 ts3d::toHalf( float const value ) {
+    A3DUns32 bits = 0u;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+    auto const sign = static_cast<A3DUns16>( (bits >> 16) & 0x8000u );
+    auto const abs_bits = bits & 0x7fffffffu;
+    if( abs_bits >= 0x7f800000u ) {
+        // infinity or NaN
+        return sign | static_cast<A3DUns16>( abs_bits > 0x7f800000u ? 0x7e00u : 0x7c00u );
+    }
+    if( abs_bits >= 0x477ff000u ) {
+        // rounds beyond the largest half float
+        return sign | static_cast<A3DUns16>( 0x7c00u );
+    }
+    if( abs_bits < 0x38800000u ) {
+        // subnormal half float, the scaling by 2^24 is exact
+        return sign | static_cast<A3DUns16>( std::nearbyint( std::fabs( value ) * 16777216.f ) );
+    }
+    auto const rounded = abs_bits + 0xfffu + ((abs_bits >> 13) & 1u);
+    return sign | static_cast<A3DUns16>( (rounded - 0x38000000u) >> 13 );
+}
+
+float ts3d::fromHalf( A3DUns16 const half ) {
+    auto const sign = (half & 0x8000u) ? -1.f : 1.f;
+    auto const exponent = (half >> 10) & 0x1fu;
+    auto const mantissa = half & 0x3ffu;
+    if( 0u == exponent ) {
+        return sign * std::ldexp( static_cast<float>( mantissa ), -24 );
+    }
+    if( 0x1fu == exponent ) {
+        return mantissa ? std::numeric_limits<float>::quiet_NaN() : sign * std::numeric_limits<float>::infinity();
+    }
+    return sign * std::ldexp( static_cast<float>( mantissa | 0x400u ), static_cast<int>( exponent ) - 25 );
+}
+
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
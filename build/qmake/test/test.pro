@@ -22,3 +22,4 @@ SOURCES += ../../../test/main.cpp \
            ../../../test/traversal.cpp \
            ../../../test/deep_dive.cpp \
            ../../../test/pmi.cpp \
+           ../../../test/benchmark.cpp \
@@ -71,11 +71,11 @@ int main( int argc, char *argv[] ) {
 
     //! [Constructing a BOM]
     
-    // An instance path map will be used to count the number of part occurrences
-    ts3d::InstancePathMap instance_paths;
+    // An instance count map will be used to count the number of part occurrences
+    ts3d::InstanceCountMap instance_counts;
 
-    // Obtain a set of unique part definition children
-    auto const part_definitions = ts3d::getUniqueLeafEntities( loader.m_psModelFile, kA3DTypeAsmPartDefinition, instance_paths );
+    // Obtain a set of unique part definition children and count their occurrences
+    auto const part_definitions = ts3d::getUniqueLeafEntities( loader.m_psModelFile, kA3DTypeAsmPartDefinition, instance_counts );
 
     // Iterator over each unique part
     for( auto part_definition : part_definitions ) {
@@ -85,9 +85,9 @@ int main( int argc, char *argv[] ) {
 
         // Print the part name and number of occurrences
         std::cout << "\"" << part_name << "\": "
-                  << "(" << instance_paths[part_definition].size() 
+                  << "(" << instance_counts[part_definition] 
                   << " instance" 
-                  << (1 != instance_paths[part_definition].size() ? "s)" : ")") 
+                  << (1 != instance_counts[part_definition] ? "s)" : ")") 
                   << std::endl;
     }
     //! [Constructing a BOM]
@@ -124,30 +124,28 @@ int main( int argc, char *argv[] ) {
         }
         
         auto const net_matrix = ts3d::getNetMatrix( ri );
-        auto const exchange_coords = tess3d->coords();
         auto const n_coords = tess3d->coordsSize();
+        std::vector<double> coords( n_coords );
+        ts3d::transformPoints( net_matrix, tess3d->coords(), coords.data(), n_coords / 3 );
         for( auto idx = 0u; idx < n_coords; idx += 3 ) {
-            auto v = net_matrix * ts3d::VectorType( exchange_coords[idx], exchange_coords[idx+1], exchange_coords[idx+2], 1. );
-            obj_file << "v " << v(0) << " " << v(1) << " " << v(2) << std::endl;
+            obj_file << "v " << coords[idx] << " " << coords[idx+1] << " " << coords[idx+2] << std::endl;
         }
         
-        auto const exchange_normals = tess3d->normals();
         auto const n_normals = tess3d->normalsSize();
+        std::vector<double> normals( n_normals );
+        ts3d::transformNormals( net_matrix, tess3d->normals(), normals.data(), n_normals / 3 );
         for( auto idx = 0u; idx < n_normals; idx += 3 ) {
-            auto n = net_matrix * ts3d::VectorType( exchange_normals[idx], exchange_normals[idx+1], exchange_normals[idx+2], 0. );
-            obj_file << "vn " << n(0) << " " << n(1) << " " << n(2) << std::endl;
+            obj_file << "vn " << normals[idx] << " " << normals[idx+1] << " " << normals[idx+2] << std::endl;
         }
         
-        for( auto idx = 0u; idx < tess3d->faceSize(); ++idx ) {
-            auto const face_mesh = tess3d->getIndexMeshForFace( idx );
-            auto const n_vertices = face_mesh.vertices().size();
-            for(auto idx = 0u; idx < n_vertices; ++idx ) {
-                if( 0 == idx % 3 ) {
-                    obj_file << std::endl << "f";
-                }
-                
-                obj_file << " -" << (n_coords - face_mesh.vertices()[idx])/3 << "//-" << (n_normals - face_mesh.normals()[idx])/3;
+        auto const body_mesh = tess3d->getIndexMesh();
+        auto const n_vertices = body_mesh._vertices.size();
+        for(auto idx = 0u; idx < n_vertices; ++idx ) {
+            if( 0 == idx % 3 ) {
+                obj_file << std::endl << "f";
             }
+            
+            obj_file << " -" << (n_coords - body_mesh._vertices[idx])/3 << "//-" << (n_normals - body_mesh._normals[idx])/3;
         }
         obj_file << std::endl;
     }
@@ -0,0 +1,249 @@
+#ifdef _MSC_VER
+#define NOMINMAX
+#endif
+
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <unordered_map>
+#include <functional>
+#include <vector>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+#include <A3DSDKIncludes.h>
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4503)
+#endif
+
+#include <ExchangeToolkit.h>
+#include <ExchangeEigenBridge.h>
+#include "catch.hpp"
+
+#define xstr(s) __str(s)
+#define __str(s) #s
+static std::string const exchange_path = xstr(HOOPS_EXCHANGE_PATH);
+
+A3DAsmModelFile *getModelFile( std::string const &fn );
+void freeModelFile( void );
+
+// These test cases are hidden by default. Run them explicitly with the
+// [Benchmark] tag to print timings to standard out.
+TEST_CASE( "Traversal per-node overhead", "[.][Benchmark]" ) {
+    auto const input_file = GENERATE( exchange_path + "/samples/data/catiaV5/CV5_Micro_Engine/_micro engine.CATProduct",
+                                     exchange_path + "/samples/data/catiaV5/CV5_Landing Gear Model/_LandingGear.CATProduct",
+                                     exchange_path + "/samples/data/solidworks/SLW_Diskbrakeassembly/_DiskBrakeAssembly-01FINAL.SLDASM" );
+    
+    auto const model_file = getModelFile( input_file );
+    REQUIRE( model_file != nullptr );
+    
+    auto const leaf_entity_type = GENERATE( kA3DTypeAsmPartDefinition, kA3DTypeRiRepresentationItem, kA3DTypeTopoFace, kA3DTypeTopoCoEdge );
+    auto const n_iterations = 10u;
+    
+    auto n_paths = size_t( 0u );
+    auto n_nodes = size_t( 0u );
+    auto const start = std::chrono::steady_clock::now();
+    for( auto iteration = 0u; iteration < n_iterations; ++iteration ) {
+        for( auto const &path : ts3d::leafInstances( model_file, leaf_entity_type ) ) {
+            ++n_paths;
+            n_nodes += path.size();
+        }
+    }
+    auto const elapsed = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+    
+    REQUIRE( n_paths == n_iterations * ts3d::getLeafInstances( model_file, leaf_entity_type ).size() );
+    
+    std::cout << input_file << " [" << A3DMiscGetEntityTypeMsg( leaf_entity_type ) << "]: "
+              << n_paths / n_iterations << " paths, "
+              << elapsed / n_iterations / 1.e6 << " ms per traversal, "
+              << (n_paths ? elapsed / n_paths : 0.) << " ns per path, "
+              << (n_nodes ? elapsed / n_nodes : 0.) << " ns per path entry" << std::endl;
+}
+
+// Compares the cost of obtaining the children of each node the way the
+// traversal used to, through nested hash maps of std::function returning a
+// new array, against the decomposition table's getters, which are resolved
+// once and append into a reused array. Both read the same (parent, child
+// type) steps, taken from the paths to each leaf type.
+TEST_CASE( "Child decomposition per-node overhead", "[.][Benchmark]" ) {
+    auto const input_file = GENERATE( exchange_path + "/samples/data/catiaV5/CV5_Micro_Engine/_micro engine.CATProduct",
+                                     exchange_path + "/samples/data/catiaV5/CV5_Landing Gear Model/_LandingGear.CATProduct",
+                                     exchange_path + "/samples/data/solidworks/SLW_Diskbrakeassembly/_DiskBrakeAssembly-01FINAL.SLDASM" );
+    
+    auto const model_file = getModelFile( input_file );
+    REQUIRE( model_file != nullptr );
+    
+    auto const leaf_entity_type = GENERATE( kA3DTypeAsmPartDefinition, kA3DTypeRiRepresentationItem, kA3DTypeTopoFace, kA3DTypeTopoCoEdge );
+    auto const n_iterations = 10u;
+    
+    using Step = std::pair<A3DEntity*, A3DEEntityType>;
+    std::set<Step> unique_steps;
+    for( auto const &path : ts3d::leafInstances( model_file, leaf_entity_type ) ) {
+        for( auto idx = 1u; idx < path.size(); ++idx ) {
+            unique_steps.insert( Step( path[idx - 1], getBaseType( ts3d::getEntityType( path[idx] ) ) ) );
+        }
+    }
+    
+    using LegacyGetter = std::function<ts3d::EntityArray( A3DEntity* )>;
+    std::unordered_map<A3DEEntityType, std::unordered_map<A3DEEntityType, LegacyGetter>> legacy_getters;
+    std::vector<Step> steps;
+    std::vector<A3DEEntityType> owner_types;
+    std::vector<ChildGetter> getters;
+    for( auto const &step : unique_steps ) {
+        auto const owner_type = getBaseType( ts3d::getEntityType( step.first ) );
+        auto const getter = getChildGetter( owner_type, step.second );
+        if( nullptr == getter ) {
+            continue;
+        }
+        legacy_getters[owner_type][step.second] = [getter]( A3DEntity *ntt ) {
+            ts3d::EntityArray children;
+            getter( ntt, children );
+            return children;
+        };
+        steps.push_back( step );
+        owner_types.push_back( owner_type );
+        getters.push_back( getter );
+    }
+    
+    auto legacy_children = size_t( 0u );
+    auto const legacy_start = std::chrono::steady_clock::now();
+    for( auto iteration = 0u; iteration < n_iterations; ++iteration ) {
+        for( auto idx = 0u; idx < steps.size(); ++idx ) {
+            legacy_children += legacy_getters[owner_types[idx]][steps[idx].second]( steps[idx].first ).size();
+        }
+    }
+    auto const legacy_elapsed = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - legacy_start ).count();
+    
+    auto table_children = size_t( 0u );
+    ts3d::EntityArray children;
+    auto const table_start = std::chrono::steady_clock::now();
+    for( auto iteration = 0u; iteration < n_iterations; ++iteration ) {
+        for( auto idx = 0u; idx < steps.size(); ++idx ) {
+            children.clear();
+            getters[idx]( steps[idx].first, children );
+            table_children += children.size();
+        }
+    }
+    auto const table_elapsed = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - table_start ).count();
+    
+    REQUIRE( legacy_children == table_children );
+    
+    auto const n_steps = steps.size() * n_iterations;
+    std::cout << input_file << " [" << A3DMiscGetEntityTypeMsg( leaf_entity_type ) << "]: "
+              << steps.size() << " nodes, "
+              << (n_steps ? legacy_elapsed / n_steps : 0.) << " ns per node before (getter map), "
+              << (n_steps ? table_elapsed / n_steps : 0.) << " ns per node after (decomposition table)" << std::endl;
+}
+
+// Compares transforming the tessellation coordinates of a model one
+// VectorType at a time, as the obj example used to, against the packed
+// batch transform. An arbitrary scale and translation is used so neither
+// loop can take the identity shortcut.
+TEST_CASE( "Packed coordinate transform per-point overhead", "[.][Benchmark]" ) {
+    auto const input_file = GENERATE( exchange_path + "/samples/data/catiaV5/CV5_Micro_Engine/_micro engine.CATProduct",
+                                     exchange_path + "/samples/data/catiaV5/CV5_Landing Gear Model/_LandingGear.CATProduct",
+                                     exchange_path + "/samples/data/solidworks/SLW_Diskbrakeassembly/_DiskBrakeAssembly-01FINAL.SLDASM" );
+    
+    auto const model_file = getModelFile( input_file );
+    REQUIRE( model_file != nullptr );
+    
+    std::vector<double> src;
+    for( auto const ri : ts3d::getUniqueLeafEntities( model_file, kA3DTypeRiRepresentationItem ) ) {
+        ts3d::RepresentationItemInstance const ri_instance( ts3d::InstancePath( 1u, ri ) );
+        if( auto const tess3d = std::dynamic_pointer_cast<ts3d::Tess3DInstance>( ri_instance.getTessellation() ) ) {
+            src.insert( src.end(), tess3d->coords(), tess3d->coords() + tess3d->coordsSize() );
+        }
+    }
+    REQUIRE( !src.empty() );
+    
+    ts3d::MatrixType matrix = ts3d::MatrixType::Identity();
+    matrix.topLeftCorner<3, 3>() *= Eigen::Vector3d( 2., 3., -1. ).asDiagonal();
+    matrix.topRightCorner<3, 1>() += Eigen::Vector3d( 10., -20., 30. );
+    auto const n_points = src.size() / 3;
+    auto const n_iterations = 10u;
+    
+    std::vector<double> eigen_dst( src.size() );
+    auto const eigen_start = std::chrono::steady_clock::now();
+    for( auto iteration = 0u; iteration < n_iterations; ++iteration ) {
+        for( auto idx = 0u; idx < src.size(); idx += 3 ) {
+            auto v = matrix * ts3d::VectorType( src[idx], src[idx+1], src[idx+2], 1. );
+            eigen_dst[idx] = v(0);
+            eigen_dst[idx+1] = v(1);
+            eigen_dst[idx+2] = v(2);
+        }
+    }
+    auto const eigen_elapsed = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - eigen_start ).count();
+    
+    std::vector<double> packed_dst( src.size() );
+    auto const packed_start = std::chrono::steady_clock::now();
+    for( auto iteration = 0u; iteration < n_iterations; ++iteration ) {
+        ts3d::transformPoints( matrix, src.data(), packed_dst.data(), n_points );
+    }
+    auto const packed_elapsed = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - packed_start ).count();
+    
+    for( auto idx = 0u; idx < src.size(); ++idx ) {
+        REQUIRE( std::abs( eigen_dst[idx] - packed_dst[idx] ) < 1e-9 );
+    }
+    
+    auto const n_transforms = n_points * n_iterations;
+    std::cout << input_file << ": "
+              << n_points << " points, "
+              << eigen_elapsed / n_transforms << " ns per point before (VectorType loop), "
+              << packed_elapsed / n_transforms << " ns per point after (transformPoints), "
+              << (packed_elapsed > 0. ? eigen_elapsed / packed_elapsed : 0.) << "x" << std::endl;
+}
+
+// Compares decoding the index mesh of the largest body of each model
+// serially and in parallel, with the default thread count and chunk size.
+TEST_CASE( "Parallel index mesh decoding", "[.][Benchmark]" ) {
+    auto const input_file = GENERATE( exchange_path + "/samples/data/catiaV5/CV5_Micro_Engine/_micro engine.CATProduct",
+                                     exchange_path + "/samples/data/catiaV5/CV5_Landing Gear Model/_LandingGear.CATProduct",
+                                     exchange_path + "/samples/data/solidworks/SLW_Diskbrakeassembly/_DiskBrakeAssembly-01FINAL.SLDASM" );
+    
+    auto const model_file = getModelFile( input_file );
+    REQUIRE( model_file != nullptr );
+    
+    std::shared_ptr<ts3d::Tess3DInstance> largest;
+    auto largest_triangles = size_t( 0u );
+    for( auto const ri : ts3d::getUniqueLeafEntities( model_file, kA3DTypeRiRepresentationItem ) ) {
+        ts3d::RepresentationItemInstance const ri_instance( ts3d::InstancePath( 1u, ri ) );
+        if( auto const tess3d = std::dynamic_pointer_cast<ts3d::Tess3DInstance>( ri_instance.getTessellation() ) ) {
+            auto const n_triangles = tess3d->getIndexMesh().triangleCount();
+            if( n_triangles > largest_triangles ) {
+                largest = tess3d;
+                largest_triangles = n_triangles;
+            }
+        }
+    }
+    REQUIRE( nullptr != largest );
+    
+    auto const n_iterations = 10u;
+    
+    ts3d::TessBodyMesh serial_mesh;
+    auto const serial_start = std::chrono::steady_clock::now();
+    for( auto iteration = 0u; iteration < n_iterations; ++iteration ) {
+        serial_mesh = largest->getIndexMesh();
+    }
+    auto const serial_elapsed = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - serial_start ).count();
+    
+    ts3d::TessBodyMesh parallel_mesh;
+    auto const parallel_start = std::chrono::steady_clock::now();
+    for( auto iteration = 0u; iteration < n_iterations; ++iteration ) {
+        parallel_mesh = largest->getIndexMeshParallel();
+    }
+    auto const parallel_elapsed = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - parallel_start ).count();
+    
+    REQUIRE( parallel_mesh._vertices == serial_mesh._vertices );
+    REQUIRE( parallel_mesh._normals == serial_mesh._normals );
+    REQUIRE( parallel_mesh._face_ids == serial_mesh._face_ids );
+    
+    std::cout << input_file << ": "
+              << largest->faceSize() << " faces, "
+              << largest_triangles << " triangles, "
+              << std::thread::hardware_concurrency() << " hardware threads, "
+              << serial_elapsed / n_iterations / 1.e6 << " ms serial, "
+              << parallel_elapsed / n_iterations / 1.e6 << " ms parallel" << std::endl;
+}
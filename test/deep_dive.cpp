@@ -5,6 +5,7 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <A3DSDKIncludes.h>
 
@@ -24,6 +25,62 @@ static std::string const exchange_path = xstr(HOOPS_EXCHANGE_PATH);
 A3DAsmModelFile *getModelFile( std::string const &fn );
 void freeModelFile( void );
 
+// A hand built face containing a single kind of triangulated entity, and the
+// corners it describes, three per triangle
+struct TessFaceFixture {
+    A3DUns16 _flag;
+    A3DUns32 _texture_count;
+    std::vector<A3DUns32> _sizes;
+    std::vector<A3DUns32> _indexes;
+    std::vector<A3DUns32> _normals;
+    std::vector<A3DUns32> _vertices;
+    std::vector<A3DUns32> _textures;
+};
+
+void testTessFaceFixture( TessFaceFixture const &fixture ) {
+    // Two unrelated values precede the face data, as they would for a second face
+    std::vector<A3DUns32> triangulated_indexes = { 999u, 999u };
+    triangulated_indexes.insert( triangulated_indexes.end(), fixture._indexes.begin(), fixture._indexes.end() );
+    auto sizes = fixture._sizes;
+    
+    A3DTessFaceData d;
+    A3D_INITIALIZE_DATA( A3DTessFaceData, d );
+    d.m_usUsedEntitiesFlags = fixture._flag;
+    d.m_uiStartTriangulated = 2u;
+    d.m_uiSizesTriangulatedSize = static_cast<A3DUns32>( sizes.size() );
+    d.m_puiSizesTriangulated = sizes.data();
+    d.m_uiTextureCoordIndexesSize = fixture._texture_count;
+    
+    auto const triangle_count = static_cast<A3DUns32>( fixture._vertices.size() / 3u );
+    REQUIRE( ts3d::getTriangleCount( d ) == triangle_count );
+    REQUIRE( ts3d::getTexturedTriangleCount( d ) == (fixture._textures.empty() ? 0u : triangle_count) );
+    
+    std::vector<A3DUns32> vertices( 3u * triangle_count ), normals( 3u * triangle_count ), textures( fixture._textures.size() );
+    REQUIRE( ts3d::decodeTriangles( d, triangulated_indexes.data(), vertices.data(), normals.data(), textures.data() ) == triangle_count );
+    REQUIRE( vertices == fixture._vertices );
+    REQUIRE( normals == fixture._normals );
+    REQUIRE( textures == fixture._textures );
+    
+    std::vector<A3DUns32> cb_vertices, cb_normals, cb_textures;
+    ts3d::decodeTriangles( d, triangulated_indexes.data(), [&]( ts3d::TessFaceCorner const &c0, ts3d::TessFaceCorner const &c1, ts3d::TessFaceCorner const &c2 ) {
+        for( auto const corner : { &c0, &c1, &c2 } ) {
+            cb_vertices.push_back( corner->_vertex );
+            cb_normals.push_back( corner->_normal );
+            if( nullptr != corner->_textures ) {
+                cb_textures.insert( cb_textures.end(), corner->_textures, corner->_textures + fixture._texture_count );
+            }
+        }
+    } );
+    REQUIRE( cb_vertices == fixture._vertices );
+    REQUIRE( cb_normals == fixture._normals );
+    REQUIRE( cb_textures == fixture._textures );
+    
+    ts3d::TessFaceDataHelper const helper( d, triangulated_indexes.data(), nullptr );
+    REQUIRE( helper.vertices() == fixture._vertices );
+    REQUIRE( helper.normals() == fixture._normals );
+    REQUIRE( helper.textures() == fixture._textures );
+}
+
 TEST_CASE( "helloworld.stp deep dive tests", "[ObjectCounts], [Instance], [Traversal], [B-Rep]" ) {
     auto const model_file = getModelFile( exchange_path + "/samples/data/step/helloworld.stp" );
     REQUIRE( model_file != nullptr );
@@ -40,6 +97,34 @@ TEST_CASE( "helloworld.stp deep dive tests", "[ObjectCounts], [Instance], [Trave
     
     auto const ri_brep_models = ts3d::getLeafInstances( model_file, kA3DTypeRiBrepModel );
     REQUIRE( ri_brep_models.size() == 10 );
+    
+    {
+        ts3d::NetMatrixCache cache;
+        auto const net_matrices = ts3d::getNetMatrices( ri_brep_models, cache );
+        REQUIRE( net_matrices.size() == ri_brep_models.size() );
+        for( auto idx = 0u; idx < ri_brep_models.size(); ++idx ) {
+            UNSCOPED_INFO( "batch net matrix matches the instance net matrix" );
+            REQUIRE( net_matrices[idx] == ts3d::getNetMatrix( ts3d::Instance( ri_brep_models[idx] ) ) );
+        }
+        UNSCOPED_INFO( "shared prefixes are computed once" );
+        REQUIRE( cache.size() < ri_brep_models.size() * ri_brep_models.front().size() );
+    }
+    
+    {
+        ts3d::TransformCache cache;
+        for( auto const &ri_brep_model_path : ri_brep_models ) {
+            for( auto const ntt : ri_brep_model_path ) {
+                auto const xform = ts3d::getEntityTransformation( ntt );
+                auto const transform = cache.get( xform );
+                UNSCOPED_INFO( "cached transform matches the decoded matrix" );
+                REQUIRE( cache.getMatrix( xform ) == ts3d::getMatrix( xform ) );
+                REQUIRE( transform._class == ts3d::AffineTransform::classify( ts3d::getMatrix( xform ) ) );
+                if( ts3d::TransformClass::Identity == transform._class ) {
+                    REQUIRE( ts3d::getMatrix( xform ) == ts3d::MatrixType::Identity() );
+                }
+            }
+        }
+    }
     for( auto const ri_brep_model_path : ri_brep_models ) {
         auto const brep_datas = ts3d::getUniqueLeafEntities( ri_brep_model_path.back(), kA3DTypeTopoBrepData );
         REQUIRE( brep_datas.size() == 1 );
@@ -99,5 +184,219 @@ TEST_CASE( "helloworld.stp deep dive tests", "[ObjectCounts], [Instance], [Trave
         REQUIRE( t->coordsSize() == 768 );
         REQUIRE( t->normalsSize() == 1530 );
         REQUIRE( t->texCoordsSize() == 0 );
+
+        ts3d::A3DTess3DWrapper d( t->leaf() );
+        for( auto face_idx = 0u; face_idx < t->faceSize(); ++face_idx ) {
+            UNSCOPED_INFO( "decoded triangles match the face helper" );
+            auto const helper = t->getIndexMeshForFace( face_idx );
+            auto const &face_data = d->m_psFaceTessData[face_idx];
+            auto const triangle_count = ts3d::getTriangleCount( face_data );
+            REQUIRE( 3u * triangle_count == helper.vertices().size() );
+            std::vector<A3DUns32> vertices( 3u * triangle_count ), normals( 3u * triangle_count );
+            REQUIRE( triangle_count == ts3d::decodeTriangles( face_data, d->m_puiTriangulatedIndexes, vertices.data(), normals.data(), nullptr ) );
+            REQUIRE( vertices == helper.vertices() );
+            REQUIRE( normals == helper.normals() );
+        }
+
+        auto const body_mesh = t->getIndexMesh();
+        REQUIRE( body_mesh._face_triangles.size() == t->faceSize() );
+        REQUIRE( body_mesh._vertices.size() == 3u * body_mesh.triangleCount() );
+        for( auto face_idx = 0u; face_idx < t->faceSize(); ++face_idx ) {
+            UNSCOPED_INFO( "body mesh matches the face helper" );
+            auto const helper = t->getIndexMeshForFace( face_idx );
+            auto const &range = body_mesh._face_triangles[face_idx];
+            REQUIRE( 3u * (range.second - range.first) == helper.vertices().size() );
+            REQUIRE( std::equal( helper.vertices().begin(), helper.vertices().end(), body_mesh._vertices.begin() + 3u * range.first ) );
+            REQUIRE( std::equal( helper.normals().begin(), helper.normals().end(), body_mesh._normals.begin() + 3u * range.first ) );
+            for( auto tri_idx = range.first; tri_idx < range.second; ++tri_idx ) {
+                REQUIRE( body_mesh._face_ids[tri_idx] == face_idx );
+            }
+        }
+
+        for( auto const thread_count : { 0u, 1u, 4u } ) {
+            UNSCOPED_INFO( "parallel body mesh is identical to the serial one" );
+            auto const parallel_mesh = t->getIndexMeshParallel( thread_count );
+            REQUIRE( parallel_mesh._vertices == body_mesh._vertices );
+            REQUIRE( parallel_mesh._normals == body_mesh._normals );
+            REQUIRE( parallel_mesh._face_triangles == body_mesh._face_triangles );
+            REQUIRE( parallel_mesh._face_ids == body_mesh._face_ids );
+        }
+
+        {
+            UNSCOPED_INFO( "parallel body mesh decoded one face per chunk is identical to the serial one" );
+            auto const parallel_mesh = t->getIndexMeshParallel( 4u, 1u );
+            REQUIRE( parallel_mesh._vertices == body_mesh._vertices );
+            REQUIRE( parallel_mesh._normals == body_mesh._normals );
+            REQUIRE( parallel_mesh._textures == body_mesh._textures );
+            REQUIRE( parallel_mesh._face_triangles == body_mesh._face_triangles );
+            REQUIRE( parallel_mesh._face_ids == body_mesh._face_ids );
+        }
+
+        auto const welded_mesh = t->getInterleavedMesh();
+        auto const per_face_mesh = t->getInterleavedMesh( ts3d::WeldMode::PerFace );
+        REQUIRE( welded_mesh._stride == 6u );
+        REQUIRE( welded_mesh._indices.size() == body_mesh._vertices.size() );
+        REQUIRE( welded_mesh.vertexCount() < welded_mesh._indices.size() );
+        REQUIRE( welded_mesh.vertexCount() <= per_face_mesh.vertexCount() );
+        for( auto idx = 0u; idx < welded_mesh._indices.size(); ++idx ) {
+            UNSCOPED_INFO( "welded vertices match the indexed coordinates" );
+            auto const vertex = welded_mesh._vertices.data() + welded_mesh._stride * welded_mesh._indices[idx];
+            REQUIRE( std::equal( vertex, vertex + 3, t->coords() + body_mesh._vertices[idx] ) );
+            REQUIRE( std::equal( vertex + 3, vertex + 6, t->normals() + body_mesh._normals[idx] ) );
+        }
+
+        auto const float32_mesh = ts3d::toFloat32( welded_mesh );
+        auto const quantized_mesh = ts3d::quantize( welded_mesh );
+        REQUIRE( float32_mesh.vertexCount() == welded_mesh.vertexCount() );
+        REQUIRE( quantized_mesh.vertexCount() == welded_mesh.vertexCount() );
+        REQUIRE( quantized_mesh._texture_coords.empty() );
+        double const origin[] = { float32_mesh._origin.m_dX, float32_mesh._origin.m_dY, float32_mesh._origin.m_dZ };
+        double const quantized_origin[] = { quantized_mesh._origin.m_dX, quantized_mesh._origin.m_dY, quantized_mesh._origin.m_dZ };
+        double const scale[] = { quantized_mesh._scale.m_dX, quantized_mesh._scale.m_dY, quantized_mesh._scale.m_dZ };
+        for( auto idx = 0u; idx < welded_mesh.vertexCount(); ++idx ) {
+            UNSCOPED_INFO( "encoded vertices decode to the original values" );
+            auto const vertex = welded_mesh._vertices.data() + welded_mesh._stride * idx;
+            for( auto axis = 0u; axis < 3u; ++axis ) {
+                REQUIRE( std::fabs( float32_mesh._vertices[welded_mesh._stride * idx + axis] + origin[axis] - vertex[axis] ) < 1e-3 );
+                REQUIRE( std::fabs( quantized_mesh._positions[3 * idx + axis] * scale[axis] + quantized_origin[axis] - vertex[axis] ) <= 0.5 * scale[axis] + 1e-9 );
+            }
+            double normal[3];
+            ts3d::decodeOctahedralNormal( quantized_mesh._normals.data() + 2 * idx, normal );
+            REQUIRE( normal[0] * vertex[3] + normal[1] * vertex[4] + normal[2] * vertex[5] > 0.9999 );
+        }
+
+        ts3d::MatrixType matrix = ts3d::getNetMatrix( ri_instance );
+        matrix.topLeftCorner<3, 3>() *= Eigen::Vector3d( 2., 3., -1. ).asDiagonal();
+        matrix.topRightCorner<3, 1>() += Eigen::Vector3d( 10., -20., 30. );
+        std::vector<double> coords( t->coordsSize() ), normals( t->normalsSize() );
+        ts3d::transformPoints( matrix, t->coords(), coords.data(), coords.size() / 3 );
+        ts3d::transformNormals( matrix, t->normals(), normals.data(), normals.size() / 3 );
+        Eigen::Matrix3d const normal_matrix = matrix.topLeftCorner<3, 3>().inverse().transpose();
+        for( auto idx = 0u; idx < coords.size(); idx += 3 ) {
+            UNSCOPED_INFO( "batch transformed points match the matrix product" );
+            ts3d::PositionType const p = matrix * ts3d::PositionType( t->coords()[idx], t->coords()[idx + 1], t->coords()[idx + 2], 1. );
+            REQUIRE( (p.head<3>() - Eigen::Vector3d( coords[idx], coords[idx + 1], coords[idx + 2] )).norm() < 1e-9 );
+        }
+        for( auto idx = 0u; idx < normals.size(); idx += 3 ) {
+            UNSCOPED_INFO( "batch transformed normals match the inverse transpose" );
+            Eigen::Vector3d const n = (normal_matrix * Eigen::Vector3d( t->normals()[idx], t->normals()[idx + 1], t->normals()[idx + 2] )).normalized();
+            REQUIRE( (n - Eigen::Vector3d( normals[idx], normals[idx + 1], normals[idx + 2] )).norm() < 1e-9 );
+        }
+    }
+    
+    auto const face_net_attributes = ri_instance.getFaceNetAttributes();
+    REQUIRE( !face_net_attributes._styles.empty() );
+    REQUIRE( face_net_attributes._styles.size() <= face_net_attributes.size() );
+    for( auto face_idx = 0u; face_idx < face_net_attributes.size(); ++face_idx ) {
+        UNSCOPED_INFO( "batch face attributes match the per face attributes" );
+        REQUIRE( face_net_attributes._removed[face_idx] == ri_instance.getNetRemoved( face_idx ) );
+        REQUIRE( face_net_attributes._show[face_idx] == ri_instance.getNetShow( face_idx ) );
+        REQUIRE( face_net_attributes._layers[face_idx] == ri_instance.getNetLayer( face_idx ) );
+        REQUIRE( isSameStyle( face_net_attributes.style( face_idx ), ri_instance.getNetStyle( face_idx ) ) );
+    }
+}
+
+TEST_CASE( "Hand built face tessellation tests", "[Tessellation]" ) {
+    // Point indexes are multiples of 3, normal indexes start at 100 and
+    // texture coordinate indexes start at 200. Fans emit (first, previous, next)
+    // and strips alternate between (previous, next, first) and (previous, first, next).
+    auto const single = static_cast<A3DUns32>( kA3DTessFaceDataNormalSingle );
+    
+    SECTION( "triangles" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangle, 0u, { 2u },
+            { 100u, 0u, 101u, 3u, 102u, 6u, 103u, 9u, 104u, 12u, 105u, 15u },
+            { 100u, 101u, 102u, 103u, 104u, 105u },
+            { 0u, 3u, 6u, 9u, 12u, 15u },
+            {} } );
+    }
+    
+    SECTION( "triangle fans" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleFan, 0u, { 1u, 4u },
+            { 100u, 0u, 101u, 3u, 102u, 6u, 103u, 9u },
+            { 100u, 101u, 102u, 100u, 102u, 103u },
+            { 0u, 3u, 6u, 0u, 6u, 9u },
+            {} } );
+    }
+    
+    SECTION( "triangle strips" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleStripe, 0u, { 1u, 4u },
+            { 100u, 0u, 101u, 3u, 102u, 6u, 103u, 9u },
+            { 101u, 102u, 100u, 102u, 101u, 103u },
+            { 3u, 6u, 0u, 6u, 3u, 9u },
+            {} } );
+    }
+    
+    SECTION( "triangles with one normal" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleOneNormal, 0u, { 2u },
+            { 100u, 0u, 3u, 6u, 101u, 9u, 12u, 15u },
+            { 100u, 100u, 100u, 101u, 101u, 101u },
+            { 0u, 3u, 6u, 9u, 12u, 15u },
+            {} } );
+    }
+    
+    SECTION( "triangle fans with one normal" ) {
+        // The first fan has a single normal, the second one normal per point
+        testTessFaceFixture( { kA3DTessFaceDataTriangleFanOneNormal, 0u, { 2u, 4u | single, 3u },
+            { 100u, 0u, 3u, 6u, 9u, 101u, 12u, 102u, 15u, 103u, 18u },
+            { 100u, 100u, 100u, 100u, 100u, 100u, 101u, 102u, 103u },
+            { 0u, 3u, 6u, 0u, 6u, 9u, 12u, 15u, 18u },
+            {} } );
+    }
+    
+    SECTION( "triangle strips with one normal" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleStripeOneNormal, 0u, { 2u, 4u | single, 3u },
+            { 100u, 0u, 3u, 6u, 9u, 101u, 12u, 102u, 15u, 103u, 18u },
+            { 100u, 100u, 100u, 100u, 100u, 100u, 102u, 103u, 101u },
+            { 3u, 6u, 0u, 6u, 3u, 9u, 15u, 18u, 12u },
+            {} } );
+    }
+    
+    SECTION( "textured triangles" ) {
+        // Two texture coordinates per point
+        testTessFaceFixture( { kA3DTessFaceDataTriangleTextured, 2u, { 1u },
+            { 100u, 200u, 201u, 0u, 101u, 202u, 203u, 3u, 102u, 204u, 205u, 6u },
+            { 100u, 101u, 102u },
+            { 0u, 3u, 6u },
+            { 200u, 201u, 202u, 203u, 204u, 205u } } );
+    }
+    
+    SECTION( "textured triangle fans" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleFanTextured, 1u, { 1u, 4u },
+            { 100u, 200u, 0u, 101u, 201u, 3u, 102u, 202u, 6u, 103u, 203u, 9u },
+            { 100u, 101u, 102u, 100u, 102u, 103u },
+            { 0u, 3u, 6u, 0u, 6u, 9u },
+            { 200u, 201u, 202u, 200u, 202u, 203u } } );
+    }
+    
+    SECTION( "textured triangle strips" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleStripeTextured, 1u, { 1u, 4u },
+            { 100u, 200u, 0u, 101u, 201u, 3u, 102u, 202u, 6u, 103u, 203u, 9u },
+            { 101u, 102u, 100u, 102u, 101u, 103u },
+            { 3u, 6u, 0u, 6u, 3u, 9u },
+            { 201u, 202u, 200u, 202u, 201u, 203u } } );
+    }
+    
+    SECTION( "textured triangles with one normal" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleOneNormalTextured, 1u, { 2u },
+            { 100u, 200u, 0u, 201u, 3u, 202u, 6u, 101u, 203u, 9u, 204u, 12u, 205u, 15u },
+            { 100u, 100u, 100u, 101u, 101u, 101u },
+            { 0u, 3u, 6u, 9u, 12u, 15u },
+            { 200u, 201u, 202u, 203u, 204u, 205u } } );
+    }
+    
+    SECTION( "textured triangle fans with one normal" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleFanOneNormalTextured, 1u, { 2u, 4u | single, 3u },
+            { 100u, 200u, 0u, 201u, 3u, 202u, 6u, 203u, 9u, 101u, 204u, 12u, 102u, 205u, 15u, 103u, 206u, 18u },
+            { 100u, 100u, 100u, 100u, 100u, 100u, 101u, 102u, 103u },
+            { 0u, 3u, 6u, 0u, 6u, 9u, 12u, 15u, 18u },
+            { 200u, 201u, 202u, 200u, 202u, 203u, 204u, 205u, 206u } } );
+    }
+    
+    SECTION( "textured triangle strips with one normal" ) {
+        testTessFaceFixture( { kA3DTessFaceDataTriangleStripeOneNormalTextured, 1u, { 2u, 4u | single, 3u },
+            { 100u, 200u, 0u, 201u, 3u, 202u, 6u, 203u, 9u, 101u, 204u, 12u, 102u, 205u, 15u, 103u, 206u, 18u },
+            { 100u, 100u, 100u, 100u, 100u, 100u, 102u, 103u, 101u },
+            { 3u, 6u, 0u, 6u, 3u, 9u, 15u, 18u, 12u },
+            { 201u, 202u, 200u, 202u, 201u, 203u, 205u, 206u, 204u } } );
     }
 }
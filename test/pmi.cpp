@@ -2,9 +2,11 @@
 #define NOMINMAX
 #endif
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <A3DSDKIncludes.h>
 
@@ -92,6 +94,52 @@ void testLinkedItemConsistency( ts3d::InstancePathArray const &all_markups ) {
 
 }
 
+void testMarkupTessellationConsistency( ts3d::InstancePathArray const &all_markups ) {
+    for( auto const &this_markup : all_markups ) {
+        ts3d::A3DMkpMarkupWrapper d( this_markup.back() );
+        if( nullptr == d->m_pTessellation ) {
+            continue;
+        }
+
+        auto tess_path = this_markup;
+        tess_path.push_back( d->m_pTessellation );
+        ts3d::TessMarkupInstance const tess( tess_path );
+
+        auto const &offsets = tess.polylineOffsets();
+        REQUIRE( !offsets.empty() );
+        REQUIRE( 0u == offsets.front() );
+        REQUIRE( std::is_sorted( offsets.begin(), offsets.end() ) );
+        REQUIRE( tess.polylinePoints().size() == 3u * offsets.back() );
+        REQUIRE( 0u == tess.triangles().size() % 9u );
+        REQUIRE( 0u == tess.points().size() % 3u );
+        REQUIRE( 0u == tess.matrices().size() % 16u );
+
+        for( auto const &state : tess.states() ) {
+            REQUIRE( (~0u == state._matrix || 16u * state._matrix < tess.matrices().size()) );
+        }
+
+        // Batches cover each primitive buffer contiguously and in order
+        std::pair<A3DUns32, A3DUns32> const empty_range( 0u, 0u );
+        ts3d::TessMarkupInstance::Batch previous = { 0u, empty_range, empty_range, empty_range, empty_range };
+        for( auto const &batch : tess.batches() ) {
+            REQUIRE( batch._state < tess.states().size() );
+            REQUIRE( batch._polylines.first == previous._polylines.second );
+            REQUIRE( batch._triangles.first == previous._triangles.second );
+            REQUIRE( batch._points.first == previous._points.second );
+            REQUIRE( batch._texts.first == previous._texts.second );
+            previous = batch;
+        }
+        REQUIRE( previous._polylines.second == offsets.size() - 1u );
+        REQUIRE( 9u * previous._triangles.second == tess.triangles().size() );
+        REQUIRE( 3u * previous._points.second == tess.points().size() );
+        REQUIRE( previous._texts.second == tess.texts().size() );
+
+        for( auto const &text_run : tess.texts() ) {
+            REQUIRE_NOTHROW( tess.getText( text_run._text ) );
+        }
+    }
+}
+
 TEST_CASE( "CV5_Sample.CATPart deep dive tests", "[PMI], [Traversal]" ) {
     auto const model_file = getModelFile( exchange_path + "/samples/data/pmi/PMI_Sample/CV5_Sample.CATPart" );
     REQUIRE( model_file != nullptr );
@@ -111,6 +159,7 @@ TEST_CASE( "CV5_Sample.CATPart deep dive tests", "[PMI], [Traversal]" ) {
     REQUIRE( 20 == all_markups.size() );
     
     testLinkedItemConsistency( all_markups );
+    testMarkupTessellationConsistency( all_markups );
     
     auto const rich_text_markups = ts3d::getLeafInstances( model_file, kA3DTypeMarkupRichText );
     REQUIRE( 5 == rich_text_markups.size() );
@@ -139,6 +188,7 @@ TEST_CASE( "Proe_sample.prt deep dive tests", "[PMI], [Traversal]" ) {
     REQUIRE( 23 == all_markups.size() );
     
     testLinkedItemConsistency( all_markups );
+    testMarkupTessellationConsistency( all_markups );
 
     auto const rich_text_markups = ts3d::getLeafInstances( model_file, kA3DTypeMarkupRichText );
     REQUIRE( 4 == rich_text_markups.size() );
@@ -167,6 +217,7 @@ TEST_CASE( "CV5_Assy_Sample_.CATProduct deep dive tests", "[PMI], [Traversal]" )
     REQUIRE( 28 == all_markups.size() );
     
     testLinkedItemConsistency( all_markups );
+    testMarkupTessellationConsistency( all_markups );
 
     auto const rich_text_markups = ts3d::getLeafInstances( model_file, kA3DTypeMarkupRichText );
     REQUIRE( 7 == rich_text_markups.size() );
@@ -186,3 +237,157 @@ TEST_CASE( "CV5_Assy_Sample_.CATProduct deep dive tests", "[PMI], [Traversal]" )
     auto const markup_views = ts3d::getLeafInstances( model_file, kA3DTypeMkpView );
     REQUIRE( 7 == markup_views.size() );
 }
+
+// Accumulates the codes and coordinates of a hand built markup tessellation
+struct MarkupCodes {
+    std::vector<A3DUns32> _codes;
+    std::vector<double> _coords;
+    
+    void append( A3DUns32 const code, std::vector<A3DUns32> const &ints, std::vector<double> const &doubles ) {
+        _codes.push_back( code | static_cast<A3DUns32>( ints.size() ) );
+        _codes.push_back( static_cast<A3DUns32>( doubles.size() ) );
+        _codes.insert( _codes.end(), ints.begin(), ints.end() );
+        _coords.insert( _coords.end(), doubles.begin(), doubles.end() );
+    }
+    
+    static A3DUns32 extraData( A3DUns32 const extra_data_type ) {
+        return kA3DMarkupIsExtraData | ((extra_data_type << 21) & kA3DMarkupExtraDataType);
+    }
+};
+
+A3DTessMarkup *createTessMarkup( MarkupCodes &markup_codes, A3DUns32 const n_texts, A3DUTF8Char **texts ) {
+    A3DTessMarkupData markup_data;
+    A3D_INITIALIZE_DATA( A3DTessMarkupData, markup_data );
+    markup_data.m_uiCodesSize = static_cast<A3DUns32>( markup_codes._codes.size() );
+    markup_data.m_puiCodes = markup_codes._codes.data();
+    markup_data.m_uiTextsSize = n_texts;
+    markup_data.m_ppcTexts = texts;
+    A3DTessMarkup *tess_markup = nullptr;
+    if( A3D_SUCCESS != A3DTessMarkupCreate( &markup_data, &tess_markup ) ) {
+        return nullptr;
+    }
+    
+    A3DTessBaseData base_data;
+    A3D_INITIALIZE_DATA( A3DTessBaseData, base_data );
+    base_data.m_uiCoordSize = static_cast<A3DUns32>( markup_codes._coords.size() );
+    base_data.m_pdCoords = markup_codes._coords.data();
+    if( A3D_SUCCESS != A3DTessBaseSet( tess_markup, &base_data ) ) {
+        A3DEntityDelete( tess_markup );
+        return nullptr;
+    }
+    return tess_markup;
+}
+
+TEST_CASE( "Hand built markup tessellation tests", "[PMI]" ) {
+    MarkupCodes markup_codes;
+    std::vector<double> const translation = { 1., 0., 0., 0., 0., 1., 0., 0., 0., 0., 1., 0., 10., 0., 0., 1. };
+    
+    // The stipple ends inside the matrix and the matrix inside the frame draw
+    // mode, so each block must only restore its own part of the state
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupColorExtraData ), { 5u }, {} );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0. } );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0., 1., 1., 0. } );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupLineStippleExtraData ), { 42u }, {} );
+    markup_codes.append( kA3DMarkupIsMatrix, {}, translation );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupFrameDrawExtraData ), {}, { 1., 2., 3. } );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupLineStippleExtraData ), {}, {} );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupTextExtraData ), { 0u }, { 3., 4. } );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0. } );
+    markup_codes.append( kA3DMarkupIsMatrix, {}, {} );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0. } );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupFrameDrawExtraData ), {}, {} );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupTrianglesExtraData ), {}, { 0., 0., 0., 1., 0., 0., 0., 1., 0. } );
+    
+    std::string text = "hello";
+    A3DUTF8Char *texts[] = { &text[0] };
+    auto const tess_markup = createTessMarkup( markup_codes, 1u, texts );
+    REQUIRE( nullptr != tess_markup );
+    
+    {
+        ts3d::TessMarkupInstance const tess( ts3d::InstancePath( 1, tess_markup ) );
+        REQUIRE( tess.polylineOffsets() == std::vector<A3DUns32>( { 0u, 2u, 5u, 7u, 9u } ) );
+        REQUIRE( 27u == tess.polylinePoints().size() );
+        REQUIRE( 9u == tess.triangles().size() );
+        REQUIRE( tess.points().empty() );
+        REQUIRE( 16u == tess.matrices().size() );
+        REQUIRE( 10. == tess.matrices()[12] );
+        REQUIRE( 1u == tess.texts().size() );
+        REQUIRE( 3. == tess.texts()[0]._width );
+        REQUIRE( 4. == tess.texts()[0]._height );
+        REQUIRE( "hello" == tess.getText( tess.texts()[0]._text ) );
+        
+        auto const &batches = tess.batches();
+        REQUIRE( 4u == batches.size() );
+        REQUIRE( 3u == tess.states().size() );
+        REQUIRE( batches[0]._polylines == std::make_pair( 0u, 2u ) );
+        REQUIRE( batches[1]._polylines == std::make_pair( 2u, 3u ) );
+        REQUIRE( batches[1]._texts == std::make_pair( 0u, 1u ) );
+        REQUIRE( batches[2]._polylines == std::make_pair( 3u, 4u ) );
+        REQUIRE( batches[3]._triangles == std::make_pair( 0u, 1u ) );
+        
+        auto const &in_matrix = tess.states()[batches[1]._state];
+        REQUIRE( 0u == in_matrix._matrix );
+        REQUIRE( 5u == in_matrix._color );
+        REQUIRE( ts3d::TessMarkupInstance::FrameDraw == in_matrix._modes );
+        REQUIRE( 2. == in_matrix._anchor[1] );
+        
+        auto const &after_matrix = tess.states()[batches[2]._state];
+        REQUIRE( ~0u == after_matrix._matrix );
+        REQUIRE( ts3d::TessMarkupInstance::FrameDraw == after_matrix._modes );
+        REQUIRE( 3. == after_matrix._anchor[2] );
+        
+        // Ending the frame draw mode restores the initial state, anchor included
+        REQUIRE( batches[3]._state == batches[0]._state );
+        auto const &after_frame_draw = tess.states()[batches[3]._state];
+        REQUIRE( ~0u == after_frame_draw._matrix );
+        REQUIRE( 0u == after_frame_draw._modes );
+        REQUIRE( 0. == after_frame_draw._anchor[2] );
+        REQUIRE( 5u == after_frame_draw._color );
+    }
+    
+    A3DEntityDelete( tess_markup );
+}
+
+TEST_CASE( "Hand built markup mode tests", "[PMI]" ) {
+    MarkupCodes markup_codes;
+    
+    // The face view mode ends while the fixed size mode begun inside it is
+    // still active, so the end must match the face view block
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupFaceViewExtraData ), {}, { 1., 1., 1. } );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0. } );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupFixedSizeExtraData ), {}, { 2., 2., 2. } );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0. } );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupFaceViewExtraData ), {}, {} );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0. } );
+    markup_codes.append( MarkupCodes::extraData( kA3DMarkupFixedSizeExtraData ), {}, {} );
+    markup_codes.append( 0u, {}, { 0., 0., 0., 1., 0., 0. } );
+    
+    auto const tess_markup = createTessMarkup( markup_codes, 0u, nullptr );
+    REQUIRE( nullptr != tess_markup );
+    
+    {
+        ts3d::TessMarkupInstance const tess( ts3d::InstancePath( 1, tess_markup ) );
+        auto const &batches = tess.batches();
+        REQUIRE( 4u == batches.size() );
+        
+        auto const &face_view = tess.states()[batches[0]._state];
+        REQUIRE( ts3d::TessMarkupInstance::FaceView == face_view._modes );
+        REQUIRE( 1. == face_view._anchor[0] );
+        
+        auto const &both = tess.states()[batches[1]._state];
+        REQUIRE( (ts3d::TessMarkupInstance::FaceView | ts3d::TessMarkupInstance::FixedSize) == both._modes );
+        REQUIRE( 2. == both._anchor[0] );
+        
+        // The fixed size block is still the innermost one, so it keeps its anchor
+        auto const &fixed_size = tess.states()[batches[2]._state];
+        REQUIRE( ts3d::TessMarkupInstance::FixedSize == fixed_size._modes );
+        REQUIRE( 2. == fixed_size._anchor[0] );
+        
+        // Ending the fixed size mode restores the anchor from before the face view mode
+        auto const &after = tess.states()[batches[3]._state];
+        REQUIRE( 0u == after._modes );
+        REQUIRE( 0. == after._anchor[0] );
+    }
+    
+    A3DEntityDelete( tess_markup );
+}
@@ -2,9 +2,13 @@
 #define NOMINMAX
 #endif
 
+#include <algorithm>
+#include <iterator>
+#include <set>
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 #include <A3DSDKIncludes.h>
 
@@ -22,6 +26,54 @@ static std::string const exchange_path = xstr(HOOPS_EXCHANGE_PATH);
 A3DAsmModelFile *getModelFile( std::string const &fn );
 void freeModelFile( void );
 
+// Reference implementation of getLeafInstances for the leaf types used in these
+// tests, independent of the traversal engine. It follows the type path with
+// single level getChildren calls, recursing into sub-assemblies and into sets of
+// representation items. Paths of a product occurrence's children come before
+// its own, as they always have.
+void collectLeafInstances( A3DEntity *owner, ts3d::EntityTypeArray const &type_path, size_t const depth, ts3d::InstancePath path, ts3d::InstancePathArray &result ) {
+    path.push_back( owner );
+    auto const owner_type = ts3d::getEntityType( owner );
+    if( kA3DTypeAsmProductOccurrence == owner_type ) {
+        for( auto const child : ts3d::getChildren( owner, kA3DTypeAsmProductOccurrence ) ) {
+            collectLeafInstances( child, type_path, depth, path, result );
+        }
+    } else if( kA3DTypeRiSet == owner_type ) {
+        auto const children = ts3d::getChildren( owner, kA3DTypeRiRepresentationItem );
+        for( auto const child : children ) {
+            collectLeafInstances( child, type_path, depth, path, result );
+        }
+        if( !children.empty() ) {
+            return;
+        }
+    }
+    
+    if( depth + 1 == type_path.size() ) {
+        result.push_back( path );
+        return;
+    }
+    for( auto const child : ts3d::getChildren( owner, type_path[depth + 1] ) ) {
+        collectLeafInstances( child, type_path, depth + 1, path, result );
+    }
+}
+
+ts3d::InstancePathArray getReferenceLeafInstances( A3DAsmModelFile *model_file, A3DEEntityType const &leaf_type ) {
+    ts3d::EntityTypeArray type_path = { kA3DTypeAsmModelFile, kA3DTypeAsmProductOccurrence };
+    if( kA3DTypeAsmProductOccurrence != leaf_type ) {
+        type_path.push_back( kA3DTypeAsmPartDefinition );
+    }
+    if( kA3DTypeAsmProductOccurrence != leaf_type && kA3DTypeAsmPartDefinition != leaf_type ) {
+        type_path.push_back( kA3DTypeRiRepresentationItem );
+    }
+    
+    ts3d::InstancePathArray all_paths, result;
+    collectLeafInstances( model_file, type_path, 0u, ts3d::InstancePath(), all_paths );
+    std::copy_if( all_paths.begin(), all_paths.end(), std::back_inserter( result ), [&leaf_type]( ts3d::InstancePath const &path ) {
+        return ts3d::getEntityType( path.back() ) == leaf_type;
+    });
+    return result;
+}
+
 TEST_CASE( "High level product traversal tests", "[Traversal]" ) {
     auto const input_file = GENERATE( exchange_path + "/samples/data/catiaV5/CV5_Aquo_Bottle/_Aquo Bottle.CATProduct",
                                      exchange_path + "/samples/data/catiaV5/CV5_Micro_Engine/_micro engine.CATProduct",
@@ -70,6 +122,190 @@ TEST_CASE( "High level product traversal tests", "[Traversal]" ) {
         }
     }
     
+    SECTION( "streaming leaf instance tests" ) {
+        auto const leaf_pos = getReferenceLeafInstances( model_file, leaf_entity_type );
+        auto idx = 0u;
+        for( auto const &path : ts3d::leafInstances( model_file, leaf_entity_type ) ) {
+            UNSCOPED_INFO( "streamed path count does not exceed array size" );
+            REQUIRE( idx < leaf_pos.size() );
+            
+            UNSCOPED_INFO( "streamed path matches array order" );
+            REQUIRE( path == leaf_pos[idx++] );
+        }
+        UNSCOPED_INFO( "all paths are streamed" );
+        REQUIRE( idx == leaf_pos.size() );
+        
+        UNSCOPED_INFO( "getLeafInstances matches the reference traversal" );
+        REQUIRE( ts3d::getLeafInstances( model_file, leaf_entity_type ) == leaf_pos );
+        
+        auto const range = ts3d::leafInstances( model_file, leaf_entity_type );
+        auto it = range.begin();
+        if( !leaf_pos.empty() ) {
+            UNSCOPED_INFO( "early termination yields the first path" );
+            REQUIRE( it != range.end() );
+            REQUIRE( *it == leaf_pos.front() );
+        } else {
+            REQUIRE( it == range.end() );
+        }
+    }
+    
+    SECTION( "pruned traversal tests" ) {
+        auto const leaf_pos = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        ts3d::InstancePathArray visited;
+        auto const completed = ts3d::visitLeafInstances( model_file, leaf_entity_type, ts3d::TraversalCallback(), [&visited]( ts3d::InstancePath const &path ) {
+            visited.push_back( path );
+            return ts3d::TraversalAction::Continue;
+        });
+        UNSCOPED_INFO( "visiting without pruning matches getLeafInstances" );
+        REQUIRE( completed );
+        REQUIRE( visited == leaf_pos );
+        
+        auto n_leaves = 0u;
+        ts3d::visitLeafInstances( model_file, leaf_entity_type, []( ts3d::InstancePath const &path ) {
+            return path.size() > 1 ? ts3d::TraversalAction::SkipSubtree : ts3d::TraversalAction::Continue;
+        }, [&n_leaves]( ts3d::InstancePath const & ) {
+            ++n_leaves;
+            return ts3d::TraversalAction::Continue;
+        });
+        UNSCOPED_INFO( "pruning below the model file yields no leaves" );
+        REQUIRE( 0u == n_leaves );
+        
+        if( !leaf_pos.empty() ) {
+            auto const stopped = ts3d::visitLeafInstances( model_file, leaf_entity_type, ts3d::TraversalCallback(), [&n_leaves]( ts3d::InstancePath const & ) {
+                ++n_leaves;
+                return ts3d::TraversalAction::Stop;
+            });
+            UNSCOPED_INFO( "stop terminates after the first leaf" );
+            REQUIRE( !stopped );
+            REQUIRE( 1u == n_leaves );
+        }
+    }
+    
+    SECTION( "parallel traversal tests" ) {
+        auto const leaf_pos = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        auto const thread_count = GENERATE( 1u, 4u );
+        UNSCOPED_INFO( "parallel traversal matches serial traversal" );
+        REQUIRE( ts3d::getLeafInstancesParallel( model_file, leaf_entity_type, thread_count ) == leaf_pos );
+        REQUIRE( ts3d::getUniqueLeafEntitiesParallel( model_file, leaf_entity_type, thread_count ) == ts3d::getUniqueLeafEntities( model_file, leaf_entity_type ) );
+    }
+    
+    SECTION( "concurrent traversal tests" ) {
+        auto const leaf_pos = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        std::vector<ts3d::InstancePathArray> results( 4u );
+        std::vector<std::thread> threads;
+        for( auto &result : results ) {
+            threads.emplace_back( [&result, model_file, leaf_entity_type] {
+                result = ts3d::getLeafInstances( model_file, leaf_entity_type );
+            });
+        }
+        for( auto &thread : threads ) {
+            thread.join();
+        }
+        for( auto const &result : results ) {
+            UNSCOPED_INFO( "traversals running on separate threads match serial traversal" );
+            REQUIRE( result == leaf_pos );
+        }
+    }
+    
+    SECTION( "instance path tree tests" ) {
+        auto const leaf_pos = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        ts3d::InstancePathTree tree;
+        auto const handles = ts3d::getLeafInstances( model_file, leaf_entity_type, tree );
+        UNSCOPED_INFO( "one handle per instance path" );
+        REQUIRE( handles.size() == leaf_pos.size() );
+        
+        for( auto idx = 0u; idx < handles.size(); ++idx ) {
+            UNSCOPED_INFO( "expanded handle matches instance path" );
+            REQUIRE( tree.expand( handles[idx] ) == leaf_pos[idx] );
+            REQUIRE( tree.depth( handles[idx] ) == leaf_pos[idx].size() );
+            REQUIRE( ts3d::Instance( tree, handles[idx] ).path() == leaf_pos[idx] );
+        }
+    }
+    
+    SECTION( "path interner tests" ) {
+        auto const leaf_pos = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        ts3d::PathInterner interner;
+        auto const handles = ts3d::getLeafInstances( model_file, leaf_entity_type, interner );
+        REQUIRE( handles.size() == leaf_pos.size() );
+        
+        auto const interned_size = interner.size();
+        UNSCOPED_INFO( "interning the same paths again produces the same handles" );
+        REQUIRE( ts3d::getLeafInstances( model_file, leaf_entity_type, interner ) == handles );
+        REQUIRE( interner.size() == interned_size );
+        
+        for( auto idx = 0u; idx < handles.size(); ++idx ) {
+            UNSCOPED_INFO( "handle references the instance path" );
+            REQUIRE( handles[idx] < interner.size() );
+            REQUIRE( interner.expand( handles[idx] ) == leaf_pos[idx] );
+            REQUIRE( interner.find( leaf_pos[idx] ) == handles[idx] );
+            REQUIRE( interner.leaf( handles[idx] ) == leaf_pos[idx].back() );
+            REQUIRE( interner.depth( handles[idx] ) == leaf_pos[idx].size() );
+            
+            UNSCOPED_INFO( "parent handle references the instance path without its leaf" );
+            auto parent_path = leaf_pos[idx];
+            parent_path.pop_back();
+            REQUIRE( interner.expand( interner.parent( handles[idx] ) ) == parent_path );
+            
+            UNSCOPED_INFO( "interned instances reference the instance path and its owner" );
+            ts3d::Instance const instance( interner, handles[idx] );
+            REQUIRE( instance.path() == leaf_pos[idx] );
+            REQUIRE( instance.handle() == handles[idx] );
+            REQUIRE( instance == ts3d::Instance( leaf_pos[idx] ) );
+            REQUIRE( instance.owner().path() == parent_path );
+            
+            for( auto other_idx = idx + 1u; other_idx < handles.size(); ++other_idx ) {
+                UNSCOPED_INFO( "handles are equal only if instance paths are equal" );
+                REQUIRE( (handles[idx] == handles[other_idx]) == (leaf_pos[idx] == leaf_pos[other_idx]) );
+                REQUIRE( (instance == ts3d::Instance( interner, handles[other_idx] )) == (leaf_pos[idx] == leaf_pos[other_idx]) );
+            }
+        }
+    }
+    
+    SECTION( "multiple leaf type tests" ) {
+        ts3d::EntityTypeArray const leaf_types = { leaf_entity_type, kA3DTypeRiRepresentationItem, kA3DTypeMkpMarkup, kA3DTypeTopoFace };
+        auto const paths_by_type = ts3d::getLeafInstances( model_file, leaf_types );
+        for( auto const leaf_type : leaf_types ) {
+            UNSCOPED_INFO( "each leaf type is present" );
+            REQUIRE( paths_by_type.count( leaf_type ) == 1u );
+            
+            UNSCOPED_INFO( "paths match a traversal for the single leaf type" );
+            REQUIRE( paths_by_type.at( leaf_type ) == ts3d::getLeafInstances( model_file, leaf_type ) );
+        }
+        
+        std::unordered_map<A3DEEntityType, size_t> streamed_sizes;
+        auto const range = ts3d::leafInstances( model_file, leaf_types );
+        for( auto it = range.begin(); it != range.end(); ++it ) {
+            ++streamed_sizes[it.leafType()];
+        }
+        for( auto const &entry : paths_by_type ) {
+            UNSCOPED_INFO( "streamed paths match the collected paths" );
+            REQUIRE( streamed_sizes[entry.first] == entry.second.size() );
+        }
+    }
+    
+    SECTION( "traversal cache tests" ) {
+        ts3d::TraversalCache cache;
+        auto const leaf_pos = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        UNSCOPED_INFO( "cached traversal matches uncached traversal" );
+        REQUIRE( ts3d::getLeafInstances( model_file, leaf_entity_type, cache ) == leaf_pos );
+        
+        auto const cache_size = cache.size();
+        UNSCOPED_INFO( "repeated traversal is satisfied by the cache" );
+        REQUIRE( ts3d::getLeafInstances( model_file, leaf_entity_type, cache ) == leaf_pos );
+        REQUIRE( cache.size() == cache_size );
+        
+        ts3d::InstancePathMap instance_path_map, cached_instance_path_map;
+        UNSCOPED_INFO( "cached unique leaf entities match uncached unique leaf entities" );
+        REQUIRE( ts3d::getUniqueLeafEntities( model_file, leaf_entity_type, cached_instance_path_map, cache ) == ts3d::getUniqueLeafEntities( model_file, leaf_entity_type, instance_path_map ) );
+        REQUIRE( cached_instance_path_map == instance_path_map );
+        
+        UNSCOPED_INFO( "cached children match uncached children" );
+        REQUIRE( ts3d::getChildren( model_file, kA3DTypeAsmProductOccurrence, cache ) == root_pos );
+        
+        cache.clear();
+        REQUIRE( cache.size() == 0u );
+    }
+    
     SECTION( "unique children tests" ) {
         ts3d::InstancePathMap instance_path_map;
         auto const child_pos = ts3d::getUniqueLeafEntities( model_file, leaf_entity_type, instance_path_map );
@@ -98,4 +334,264 @@ TEST_CASE( "High level product traversal tests", "[Traversal]" ) {
             }
         }
     }
+    
+    SECTION( "leaf instance count tests" ) {
+        auto const leaf_pos = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        UNSCOPED_INFO( "count matches the number of instance paths" );
+        REQUIRE( ts3d::countLeafInstances( model_file, leaf_entity_type ) == leaf_pos.size() );
+        
+        ts3d::InstanceCountMap instance_counts;
+        REQUIRE( ts3d::countLeafInstances( model_file, leaf_entity_type, instance_counts ) == leaf_pos.size() );
+        auto sum = size_t( 0u );
+        for( auto const &entry : instance_counts ) {
+            sum += entry.second;
+        }
+        UNSCOPED_INFO( "per entity counts sum to the total count" );
+        REQUIRE( sum == leaf_pos.size() );
+        
+        auto const counts_by_type = ts3d::countLeafInstances( model_file, { leaf_entity_type, kA3DTypeTopoFace } );
+        UNSCOPED_INFO( "counts by type match the number of instance paths for each type" );
+        REQUIRE( counts_by_type.at( leaf_entity_type ) == leaf_pos.size() );
+        REQUIRE( counts_by_type.at( kA3DTypeTopoFace ) == ts3d::getLeafInstances( model_file, kA3DTypeTopoFace ).size() );
+    }
+    
+    SECTION( "flat unique children tests" ) {
+        ts3d::InstancePathMap instance_path_map;
+        auto const child_pos = ts3d::getUniqueLeafEntities( model_file, leaf_entity_type, instance_path_map );
+        
+        ts3d::FlatInstancePathMap flat_instance_path_map;
+        auto const flat_child_pos = ts3d::getUniqueLeafEntitiesFlat( model_file, leaf_entity_type, flat_instance_path_map );
+        UNSCOPED_INFO( "flat set contains the unique children" );
+        REQUIRE( flat_child_pos.toEntitySet() == child_pos );
+        REQUIRE( ts3d::getUniqueLeafEntitiesFlat( model_file, leaf_entity_type ) == flat_child_pos );
+        REQUIRE( std::is_sorted( flat_child_pos.begin(), flat_child_pos.end() ) );
+        
+        UNSCOPED_INFO( "flat map contains the same paths in the same order" );
+        REQUIRE( flat_instance_path_map.size() == instance_path_map.size() );
+        for( auto const child_po : child_pos ) {
+            REQUIRE( flat_child_pos.contains( child_po ) );
+            REQUIRE( flat_instance_path_map.paths( child_po ) == instance_path_map[child_po] );
+        }
+        REQUIRE( flat_instance_path_map.toInstancePathMap() == instance_path_map );
+    }
+    
+    SECTION( "unique children instance count tests" ) {
+        ts3d::InstancePathMap instance_path_map;
+        auto const child_pos = ts3d::getUniqueLeafEntities( model_file, leaf_entity_type, instance_path_map );
+        
+        UNSCOPED_INFO( "unique children match those obtained with instance paths" );
+        REQUIRE( ts3d::getUniqueLeafEntities( model_file, leaf_entity_type ) == child_pos );
+        
+        ts3d::InstanceCountMap instance_counts;
+        REQUIRE( ts3d::getUniqueLeafEntities( model_file, leaf_entity_type, instance_counts ) == child_pos );
+        REQUIRE( instance_counts.size() == instance_path_map.size() );
+        for( auto const &entry : instance_path_map ) {
+            UNSCOPED_INFO( "instance count matches the number of instance paths" );
+            REQUIRE( instance_counts[entry.first] == entry.second.size() );
+        }
+    }
+    
+    SECTION( "cascaded attributes cache tests" ) {
+        auto const leaf_instances = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        ts3d::CascadedAttributesCache cache;
+        for( auto const &instance_path : leaf_instances ) {
+            ts3d::Instance const instance( instance_path );
+            UNSCOPED_INFO( "cached net attributes match the instance" );
+            REQUIRE( cache.getNetRemoved( instance_path ) == instance.getNetRemoved() );
+            REQUIRE( cache.getNetShow( instance_path ) == instance.getNetShow() );
+            REQUIRE( cache.getNetLayer( instance_path ) == instance.getNetLayer() );
+            REQUIRE( isSameStyle( cache.getNetStyle( instance_path ), instance.getNetStyle() ) );
+        }
+        
+        UNSCOPED_INFO( "attributes are pushed once per prefix" );
+        auto const size = cache.size();
+        for( auto const &instance_path : leaf_instances ) {
+            cache.getNetShow( instance_path );
+        }
+        REQUIRE( cache.size() == size );
+        cache.clear();
+        REQUIRE( 0u == cache.size() );
+    }
+    
+    SECTION( "instrumentation tests" ) {
+        ts3d::Instrumentation::reset();
+        auto const leaf_instances = ts3d::getLeafInstances( model_file, leaf_entity_type );
+        auto const snapshot = ts3d::Instrumentation::snapshot();
+        
+        auto get_calls = 0ull;
+        for( auto const &get : snapshot._gets ) {
+            get_calls += get._calls;
+        }
+        if( ts3d::Instrumentation::enabled() ) {
+            UNSCOPED_INFO( "instrumentation counts calls and paths" );
+            REQUIRE( get_calls > 0u );
+            REQUIRE( snapshot._paths == leaf_instances.size() );
+            for( auto const &instance_path : leaf_instances ) {
+                REQUIRE( instance_path.size() <= snapshot._max_depth );
+            }
+            REQUIRE( (leaf_instances.empty() || snapshot._path_bytes > 0u) );
+        } else {
+            UNSCOPED_INFO( "nothing is counted when instrumentation is disabled" );
+            REQUIRE( 0u == get_calls );
+            REQUIRE( 0u == snapshot._paths );
+            REQUIRE( 0u == snapshot._path_bytes );
+        }
+    }
+}
+
+TEST_CASE( "Wire tessellation tests", "[Traversal]" ) {
+    std::string const input_files[] = { exchange_path + "/samples/data/catiaV5/CV5_Aquo_Bottle/_Aquo Bottle.CATProduct",
+                                        exchange_path + "/samples/data/catiaV5/CV5_Micro_Engine/_micro engine.CATProduct",
+                                        exchange_path + "/samples/data/catiaV5/CV5_Landing Gear Model/_LandingGear.CATProduct",
+                                        exchange_path + "/samples/data/drawing/Carter.CATDrawing",
+                                        exchange_path + "/samples/data/inventor/collision.iam",
+                                        exchange_path + "/samples/data/jt/Flange287.jt",
+                                        exchange_path + "/samples/data/pmi/PMI_Sample/asm/CV5_Assy_Sample_.CATProduct",
+                                        exchange_path + "/samples/data/pmi/PMI_Sample/CV5_Sample.CATPart",
+                                        exchange_path + "/samples/data/prc/__drill.prc",
+                                        exchange_path + "/samples/data/solidworks/SLW_Diskbrakeassembly/_DiskBrakeAssembly-01FINAL.SLDASM",
+                                        exchange_path + "/samples/data/step/Flange287.stp" };
+    
+    // Not every file has wire tessellation, but the files together must
+    auto n_wires = 0u;
+    for( auto const &input_file : input_files ) {
+        auto const model_file = getModelFile( input_file );
+        REQUIRE( model_file != nullptr );
+        
+        auto const ri_instances = ts3d::getLeafInstances( model_file, kA3DTypeRiRepresentationItem );
+        for( auto const &instance_path : ri_instances ) {
+            auto const wire = std::dynamic_pointer_cast<ts3d::Tess3DWireInstance>( ts3d::RepresentationItemInstance( instance_path ).getTessellation() );
+            if( nullptr == wire ) {
+                continue;
+            }
+            n_wires += wire->getNumberOfWires();
+            UNSCOPED_INFO( "wire offsets partition the vertex array" );
+            auto const &offsets = wire->offsets();
+            REQUIRE( offsets.size() == wire->getNumberOfWires() + 1u );
+            REQUIRE( offsets.front() == 0u );
+            REQUIRE( offsets.back() == wire->verticesSize() );
+            REQUIRE( std::is_sorted( offsets.begin(), offsets.end() ) );
+            REQUIRE( wire->closed().size() == wire->getNumberOfWires() );
+            REQUIRE( wire->connectedToPrevious().size() == wire->getNumberOfWires() );
+            for( auto idx = 0u; idx < wire->verticesSize(); ++idx ) {
+                REQUIRE( wire->vertices()[idx] + 2u < wire->coordsSize() );
+            }
+        }
+    }
+    REQUIRE( n_wires > 0u );
+}
+
+// Creates a wire tessellation of four points with the given wire sizes,
+// including their flags, wire indexes and colors
+A3DTess3DWire *createTess3DWire( std::vector<A3DUns32> &sizes, std::vector<A3DUns32> &indexes, std::vector<A3DUns8> &colors, bool const is_rgba, bool const is_segment_color ) {
+    A3DTess3DWireData wire_data;
+    A3D_INITIALIZE_DATA( A3DTess3DWireData, wire_data );
+    wire_data.m_uiSizesWiresSize = static_cast<A3DUns32>( sizes.size() );
+    wire_data.m_puiSizesWires = sizes.data();
+    wire_data.m_uiWireIndexesSize = static_cast<A3DUns32>( indexes.size() );
+    wire_data.m_puiWireIndexes = indexes.data();
+    wire_data.m_bIsRGBA = is_rgba ? A3D_TRUE : A3D_FALSE;
+    wire_data.m_bIsSegmentColor = is_segment_color ? A3D_TRUE : A3D_FALSE;
+    wire_data.m_uiRGBAVerticesSize = static_cast<A3DUns32>( colors.size() );
+    wire_data.m_pucRGBAVertices = colors.empty() ? nullptr : colors.data();
+    A3DTess3DWire *tess_wire = nullptr;
+    if( A3D_SUCCESS != A3DTess3DWireCreate( &wire_data, &tess_wire ) ) {
+        return nullptr;
+    }
+    
+    static double coords[] = { 0., 0., 0., 1., 0., 0., 1., 1., 0., 0., 1., 0. };
+    A3DTessBaseData base_data;
+    A3D_INITIALIZE_DATA( A3DTessBaseData, base_data );
+    base_data.m_uiCoordSize = 12u;
+    base_data.m_pdCoords = coords;
+    if( A3D_SUCCESS != A3DTessBaseSet( tess_wire, &base_data ) ) {
+        A3DEntityDelete( tess_wire );
+        return nullptr;
+    }
+    return tess_wire;
+}
+
+TEST_CASE( "Hand built wire tessellation tests", "[Traversal]" ) {
+    // A closed triangle, a segment continuing from it, and a closing segment
+    // continuing from that
+    std::vector<A3DUns32> sizes = { 3u | kA3DTess3DWireDataIsClosing, 2u | kA3DTess3DWireDataIsContinuous, 2u | kA3DTess3DWireDataIsClosing | kA3DTess3DWireDataIsContinuous };
+    std::vector<A3DUns32> indexes = { 0u, 3u, 6u, 6u, 9u, 9u, 0u };
+    
+    SECTION( "per vertex RGB colors" ) {
+        std::vector<A3DUns8> colors;
+        for( auto idx = 0u; idx < indexes.size(); ++idx ) {
+            colors.insert( colors.end(), { A3DUns8( 10u * idx ), A3DUns8( 20u * idx + 1u ), A3DUns8( 30u * idx + 2u ) } );
+        }
+        auto const tess_wire = createTess3DWire( sizes, indexes, colors, false, false );
+        REQUIRE( nullptr != tess_wire );
+        {
+            ts3d::Tess3DWireInstance const wire( ts3d::InstancePath( 1, tess_wire ) );
+            REQUIRE( 3u == wire.getNumberOfWires() );
+            REQUIRE( wire.offsets() == std::vector<A3DUns32>( { 0u, 3u, 5u, 7u } ) );
+            REQUIRE( 7u == wire.verticesSize() );
+            REQUIRE( std::equal( indexes.begin(), indexes.end(), wire.vertices() ) );
+            REQUIRE( wire.closed() == std::vector<bool>( { true, false, true } ) );
+            REQUIRE( wire.connectedToPrevious() == std::vector<bool>( { false, true, true } ) );
+            
+            REQUIRE( ts3d::Tess3DWireInstance::ColorSpec::RGB == wire.getColorSpecification() );
+            REQUIRE( ts3d::Tess3DWireInstance::ColorApplication::PerVertex == wire.getColorApplication() );
+            REQUIRE( indexes.size() == wire.colors().size() );
+            REQUIRE( 0xff020100u == wire.colors()[0] );
+            REQUIRE( 0xff3e2914u == wire.colors()[2] );
+            REQUIRE( 0xffb6793cu == wire.colors()[6] );
+        }
+        A3DEntityDelete( tess_wire );
+    }
+    
+    SECTION( "per segment RGBA colors" ) {
+        std::vector<A3DUns8> colors = { 0x11u, 0x22u, 0x33u, 0x44u, 0xaau, 0xbbu, 0xccu, 0x00u };
+        auto const tess_wire = createTess3DWire( sizes, indexes, colors, true, true );
+        REQUIRE( nullptr != tess_wire );
+        {
+            ts3d::Tess3DWireInstance const wire( ts3d::InstancePath( 1, tess_wire ) );
+            REQUIRE( ts3d::Tess3DWireInstance::ColorSpec::RGBA == wire.getColorSpecification() );
+            REQUIRE( ts3d::Tess3DWireInstance::ColorApplication::PerSegment == wire.getColorApplication() );
+            REQUIRE( wire.colors() == std::vector<A3DUns32>( { 0x44332211u, 0x00ccbbaau } ) );
+        }
+        A3DEntityDelete( tess_wire );
+    }
+    
+    SECTION( "wire sizes exceeding the wire indexes" ) {
+        std::vector<A3DUns8> colors;
+        indexes.pop_back();
+        auto const tess_wire = createTess3DWire( sizes, indexes, colors, false, false );
+        REQUIRE( nullptr != tess_wire );
+        REQUIRE_THROWS_AS( ts3d::Tess3DWireInstance( ts3d::InstancePath( 1, tess_wire ) ), std::out_of_range );
+        A3DEntityDelete( tess_wire );
+    }
+}
+
+TEST_CASE( "Pruned traversal of several type paths", "[Traversal], [PMI]" ) {
+    auto const input_file = GENERATE( exchange_path + "/samples/data/pmi/PMI_Sample/asm/CV5_Assy_Sample_.CATProduct",
+                                     exchange_path + "/samples/data/pmi/PMI_Sample/CV5_Sample.CATPart" );
+    
+    auto const model_file = getModelFile( input_file );
+    REQUIRE( model_file != nullptr );
+    
+    // Markup is found below both product occurrences and part definitions
+    std::set<ts3d::InstancePath> node_paths;
+    auto n_node_calls = 0u;
+    ts3d::InstancePathArray markups;
+    ts3d::visitLeafInstances( model_file, kA3DTypeMkpMarkup, [&node_paths, &n_node_calls]( ts3d::InstancePath const &path ) {
+        node_paths.insert( path );
+        ++n_node_calls;
+        return ts3d::TraversalAction::Continue;
+    }, [&markups]( ts3d::InstancePath const &path ) {
+        markups.push_back( path );
+        return ts3d::TraversalAction::Continue;
+    });
+    UNSCOPED_INFO( "each node is visited once" );
+    REQUIRE( node_paths.size() == n_node_calls );
+    
+    UNSCOPED_INFO( "the same leaves are visited as getLeafInstances returns" );
+    auto leaf_instances = ts3d::getLeafInstances( model_file, kA3DTypeMkpMarkup );
+    REQUIRE( !leaf_instances.empty() );
+    std::sort( leaf_instances.begin(), leaf_instances.end() );
+    std::sort( markups.begin(), markups.end() );
+    REQUIRE( markups == leaf_instances );
 }